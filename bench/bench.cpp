@@ -0,0 +1,1020 @@
+// Headless benchmark and regression check for the plugin modules. Drives SimpleVCO
+// and JuliaScope with scripted inputs at several sample rates, renders Julia frames at
+// several iteration counts, times wavetable loading, and reports throughput.
+//
+//   bench                 print throughput only
+//   bench --write FILE    also save golden outputs (audio samples, pixel checksums)
+//   bench --check FILE    also compare with saved golden outputs, exit 1 on mismatch
+#include "plugin.hpp"
+#include "JuliaRender.hpp"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+// The module sources only define their structs inside their own translation units,
+// so the benchmark includes them directly
+#include "../src/SimpleVCO.cpp"
+#include "../src/JuliaScope.cpp"
+
+static const float SAMPLE_RATES[] = {44100.f, 48000.f, 96000.f};
+// Seconds of audio per configuration
+static const float AUDIO_SECONDS = 2.f;
+// Samples kept per signal for the golden file
+static const int GOLDEN_SAMPLES = 8;
+// Absolute tolerance for golden audio samples, in volts
+static const float SAMPLE_TOLERANCE = 1e-4f;
+static const int RENDER_FRAMES = 10;
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Golden outputs: one line per signal, "samples NAME v0 v1 ..." compared with a
+// tolerance, or "checksum NAME HEX" compared exactly
+struct Golden {
+    struct Entry {
+        bool exact;
+        std::vector<std::string> values;
+    };
+    std::map<std::string, Entry> entries;
+    std::vector<std::string> order;
+
+    void addSamples(const std::string& name, const std::vector<float>& samples) {
+        Entry e;
+        e.exact = false;
+        for (float v : samples)
+            e.values.push_back(string::f("%.6f", v));
+        add(name, e);
+    }
+
+    void addChecksum(const std::string& name, uint64_t checksum) {
+        Entry e;
+        e.exact = true;
+        e.values.push_back(string::f("%016" PRIx64, checksum));
+        add(name, e);
+    }
+
+    void add(const std::string& name, const Entry& e) {
+        if (!entries.count(name))
+            order.push_back(name);
+        entries[name] = e;
+    }
+
+    bool write(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        for (const std::string& name : order) {
+            const Entry& e = entries.at(name);
+            out << (e.exact ? "checksum " : "samples ") << name;
+            for (const std::string& v : e.values)
+                out << " " << v;
+            out << "\n";
+        }
+        return true;
+    }
+
+    bool read(const std::string& path) {
+        std::ifstream in(path);
+        if (!in)
+            return false;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string kind, name, value;
+            if (!(fields >> kind >> name))
+                continue;
+            Entry e;
+            e.exact = (kind == "checksum");
+            while (fields >> value)
+                e.values.push_back(value);
+            add(name, e);
+        }
+        return true;
+    }
+
+    // Prints every difference from expected and returns how many signals differ
+    int compare(const Golden& expected) const {
+        int mismatches = 0;
+        for (const std::string& name : expected.order) {
+            const Entry& want = expected.entries.at(name);
+            auto it = entries.find(name);
+            if (it == entries.end()) {
+                std::printf("MISSING  %s\n", name.c_str());
+                mismatches++;
+                continue;
+            }
+            const Entry& got = it->second;
+            bool same = got.values.size() == want.values.size();
+            for (size_t i = 0; same && i < want.values.size(); i++) {
+                if (want.exact)
+                    same = got.values[i] == want.values[i];
+                else
+                    same = std::fabs(std::stof(got.values[i]) - std::stof(want.values[i])) <= SAMPLE_TOLERANCE;
+            }
+            if (!same) {
+                std::printf("CHANGED  %s\n", name.c_str());
+                mismatches++;
+            }
+        }
+        return mismatches;
+    }
+};
+
+// Keeps GOLDEN_SAMPLES evenly spaced values of a signal
+struct SampleTap {
+    int interval;
+    int next;
+    std::vector<float> samples;
+
+    explicit SampleTap(int length) : interval(std::max(1, length / GOLDEN_SAMPLES)), next(interval - 1) {}
+
+    void process(int frame, float value) {
+        if (frame == next && (int)samples.size() < GOLDEN_SAMPLES) {
+            samples.push_back(value);
+            next += interval;
+        }
+    }
+};
+
+// Wait for the pitch tracker to analyze everything pushed. The audio thread's wakeup can
+// be missed by a worker just about to wait, which in Rack only delays the analysis to the
+// next push; here nothing more is pushed, so the wait wakes the workers itself.
+static void waitForPitch(PitchTracker& tracker) {
+    while (tracker.getAnalyzed() != tracker.getPushed()) {
+        juliaScheduler.notify();
+        std::this_thread::yield();
+    }
+}
+
+static Module::ProcessArgs makeArgs(float sampleRate, int64_t frame) {
+    Module::ProcessArgs args;
+    args.sampleRate = sampleRate;
+    args.sampleTime = 1.f / sampleRate;
+    args.frame = frame;
+    return args;
+}
+
+struct VcoConfig {
+    float sampleRate;
+    int channels;
+    bool fastMath;
+    int oversample;
+    bool sync;
+    int voices;
+    // Wavetable on the sine output
+    bool wavetable;
+
+    std::string name() const {
+        return string::f("%.0f.%dch.%s%s%s%s%s", sampleRate, channels, fastMath ? "fast" : "libm",
+            oversample > 1 ? string::f(".%dx", oversample).c_str() : "", sync ? ".sync" : "",
+            voices > 1 ? string::f(".%dv", voices).c_str() : "", wavetable ? ".wt" : "");
+    }
+};
+
+static uint64_t checksum(const uint8_t* data, size_t size) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Test table written by benchWavetable(): 16 frames of 2048 samples, from saw to square
+static const int WAVETABLE_FRAMES = 16;
+static const int WAVETABLE_FRAME_LENGTH = 2048;
+static std::string wavetablePath;
+// Differences between the vector kernels and the scalar fallback, which fail the golden check
+static int kernelMismatches = 0;
+
+static void writeWavetable(const std::string& path) {
+    std::vector<int16_t> samples;
+    for (int f = 0; f < WAVETABLE_FRAMES; f++) {
+        float mix = (float)f / (WAVETABLE_FRAMES - 1);
+        for (int i = 0; i < WAVETABLE_FRAME_LENGTH; i++) {
+            float phase = (float)i / WAVETABLE_FRAME_LENGTH;
+            float saw = 2.f * phase - 1.f;
+            float square = phase < 0.5f ? 1.f : -1.f;
+            samples.push_back((int16_t)std::lround(((1.f - mix) * saw + mix * square) * 32000.f));
+        }
+    }
+
+    // 16-bit mono PCM
+    uint32_t dataSize = samples.size() * 2;
+    std::vector<uint8_t> file(44 + dataSize);
+    auto put32 = [&](size_t pos, uint32_t v) { std::memcpy(&file[pos], &v, 4); };
+    auto put16 = [&](size_t pos, uint16_t v) { std::memcpy(&file[pos], &v, 2); };
+    std::memcpy(&file[0], "RIFF", 4);
+    put32(4, 36 + dataSize);
+    std::memcpy(&file[8], "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 1);
+    put16(22, 1);
+    put32(24, 48000);
+    put32(28, 48000 * 2);
+    put16(32, 2);
+    put16(34, 16);
+    std::memcpy(&file[36], "data", 4);
+    put32(40, dataSize);
+    std::memcpy(&file[44], samples.data(), dataSize);
+    system::writeFile(path, file);
+}
+
+// Deletes the stand-in user folder's wavetable cache, so the first load builds its table
+static void clearWavetableCache() {
+    std::string dir = asset::user("TonyVCO/wavetables");
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(d)) {
+            if (entry->d_name[0] != '.')
+                system::remove(system::join(dir, entry->d_name));
+        }
+        closedir(d);
+    }
+}
+
+// Times the three ways a module gets its table: building it from the WAV file, sharing
+// the copy another module has loaded, and mapping the cache file from an earlier load
+static void benchWavetable(Golden& golden) {
+    system::createDirectories(asset::user(""));
+    wavetablePath = asset::user("bench-wavetable.wav");
+    writeWavetable(wavetablePath);
+    clearWavetableCache();
+
+    std::string error;
+    Clock::time_point start = Clock::now();
+    std::shared_ptr<const Wavetable> built = loadWavetable(wavetablePath, error);
+    double buildNs = elapsedNs(start);
+    if (!built) {
+        std::fprintf(stderr, "cannot load %s: %s\n", wavetablePath.c_str(), error.c_str());
+        std::exit(2);
+    }
+
+    start = Clock::now();
+    std::shared_ptr<const Wavetable> shared = loadWavetable(wavetablePath, error);
+    double sharedNs = elapsedNs(start);
+
+    // Memory of the table itself, shared by every module playing it
+    size_t samples = 0;
+    for (int level = 0; level < built->levels; level++)
+        samples += (size_t)built->frames * (built->levelLength[level] + 1);
+    golden.addChecksum("wavetable.levels", checksum((const uint8_t*)built->data, samples * sizeof(float)));
+    bool same = (shared == built);
+    built.reset();
+    shared.reset();
+
+    start = Clock::now();
+    std::shared_ptr<const Wavetable> mapped = loadWavetable(wavetablePath, error);
+    double mappedNs = elapsedNs(start);
+
+    std::printf("Wavetable load, %d frames of %d samples, %d mip levels, %.0f KB\n", WAVETABLE_FRAMES,
+        WAVETABLE_FRAME_LENGTH, mapped->levels, samples * sizeof(float) / 1024.0);
+    std::printf("  build and cache    %8.3f ms\n", buildNs * 1e-6);
+    std::printf("  already loaded     %8.3f ms  %s\n", sharedNs * 1e-6, same ? "(same copy)" : "(NOT SHARED)");
+    std::printf("  mapped from cache  %8.3f ms\n\n", mappedNs * 1e-6);
+}
+
+// Runs one SimpleVCO configuration and returns the time spent, in ns. With taps, also
+// records channel 0 and the last channel of every output (that pass isn't timed). With
+// counters, also returns the module's own process() timings.
+static double runSimpleVCO(const VcoConfig& config, std::vector<SampleTap>* taps, PerfSummary* counters = nullptr) {
+    std::unique_ptr<SimpleVCO> m(new SimpleVCO);
+    m->fastMath = config.fastMath;
+    m->setOversample(config.oversample);
+    m->params[SimpleVCO::FM_PARAM].setValue(0.3f);
+    m->params[SimpleVCO::VOICES_PARAM].setValue(config.voices);
+    m->params[SimpleVCO::SPREAD_PARAM].setValue(0.5f);
+    m->inputs[SimpleVCO::VOCT_INPUT].channels = config.channels;
+    m->inputs[SimpleVCO::FM_INPUT].channels = 1;
+    m->inputs[SimpleVCO::SYNC_INPUT].channels = config.sync ? 1 : 0;
+    m->params[SimpleVCO::WAVE_POSITION_PARAM].setValue(0.4f);
+    std::string error;
+    if (config.wavetable)
+        m->setWavetable(wavetablePath, error);
+    for (int i = 0; i < SimpleVCO::OUTPUTS_LEN; i++)
+        m->outputs[i].channels = 1;
+
+    float sampleRate = config.sampleRate;
+    int channels = config.channels;
+    int length = (int)(sampleRate * AUDIO_SECONDS);
+    // Scripted inputs: each channel a semitone apart, a slow pitch sweep, and audio-rate FM
+    std::vector<float> sweep(length);
+    std::vector<float> fm(length);
+    std::vector<float> sync(length);
+    for (int i = 0; i < length; i++) {
+        float t = i / sampleRate;
+        sweep[i] = std::sin(2.f * float(M_PI) * 0.5f * t);
+        fm[i] = 2.f * std::sin(2.f * float(M_PI) * 110.f * t);
+        sync[i] = 5.f * std::sin(2.f * float(M_PI) * 97.f * t);
+    }
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < length; i++) {
+        for (int c = 0; c < channels; c++)
+            m->inputs[SimpleVCO::VOCT_INPUT].setVoltage(sweep[i] + c / 12.f, c);
+        m->inputs[SimpleVCO::FM_INPUT].setVoltage(fm[i]);
+        m->inputs[SimpleVCO::SYNC_INPUT].setVoltage(sync[i]);
+        m->process(makeArgs(sampleRate, i));
+
+        if (taps) {
+            for (int o = 0; o < SimpleVCO::OUTPUTS_LEN; o++) {
+                (*taps)[2 * o].process(i, m->outputs[o].getVoltage(0));
+                (*taps)[2 * o + 1].process(i, m->outputs[o].getVoltage(channels - 1));
+            }
+        }
+    }
+    double ns = elapsedNs(start);
+    if (counters)
+        m->processTimes.histogram.read(*counters);
+    return ns;
+}
+
+static void benchSimpleVCO(Golden& golden) {
+    static const int CHANNEL_COUNTS[] = {1, 4, 16};
+    static const char* OUTPUT_NAMES[] = {"sine", "tri", "saw", "square"};
+
+    // Both math paths without oversampling, then the oversampled modes, hard sync, unison and the
+    // wavetable with fast math
+    std::vector<VcoConfig> configs;
+    for (float sampleRate : SAMPLE_RATES) {
+        for (int channels : CHANNEL_COUNTS) {
+            configs.push_back(VcoConfig{sampleRate, channels, false, 1, false, 1, false});
+            configs.push_back(VcoConfig{sampleRate, channels, true, 1, false, 1, false});
+            configs.push_back(VcoConfig{sampleRate, channels, true, 2, false, 1, false});
+            configs.push_back(VcoConfig{sampleRate, channels, true, 4, false, 1, false});
+            configs.push_back(VcoConfig{sampleRate, channels, true, 1, true, 1, false});
+            configs.push_back(VcoConfig{sampleRate, channels, true, 1, false, 4, false});
+            configs.push_back(VcoConfig{sampleRate, channels, true, 1, false, 7, false});
+            configs.push_back(VcoConfig{sampleRate, channels, true, 1, false, 8, false});
+            configs.push_back(VcoConfig{sampleRate, channels, true, 1, false, 1, true});
+        }
+    }
+
+    std::printf("SimpleVCO, all outputs connected, 97 Hz sine on SYNC when on\n");
+    std::printf("  %-8s %4s  %-5s %4s %5s %6s %4s %11s %10s %9s\n", "rate", "ch", "math", "os", "sync", "voices", "wt",
+        "ns/sample", "ns/voice", "self p99");
+
+    for (const VcoConfig& config : configs) {
+        int length = (int)(config.sampleRate * AUDIO_SECONDS);
+        PerfSummary counters;
+        double ns = runSimpleVCO(config, nullptr, &counters);
+        std::printf("  %-8.0f %4d  %-5s %3dx %5s %6d %4s %11.1f %10.1f %9.0f\n", config.sampleRate, config.channels,
+            config.fastMath ? "fast" : "libm", config.oversample, config.sync ? "on" : "off", config.voices,
+            config.wavetable ? "on" : "off", ns / length, ns / length / (config.channels * config.voices), counters.p99);
+
+        std::vector<SampleTap> taps(2 * SimpleVCO::OUTPUTS_LEN, SampleTap(length));
+        runSimpleVCO(config, &taps);
+        for (int o = 0; o < SimpleVCO::OUTPUTS_LEN; o++) {
+            std::vector<float> samples = taps[2 * o].samples;
+            samples.insert(samples.end(), taps[2 * o + 1].samples.begin(), taps[2 * o + 1].samples.end());
+            golden.addSamples("vco." + config.name() + "." + OUTPUT_NAMES[o], samples);
+        }
+    }
+    std::printf("\n");
+}
+
+// Runs JuliaScope at one sample rate and returns the time spent, in ns. With taps, also
+// records the published render snapshot: c real, c imaginary, zoom and tilt. With
+// counters, also returns the module's own process() timings.
+static double runJuliaScope(float sampleRate, std::vector<SampleTap>* taps, PerfSummary* counters = nullptr) {
+    std::unique_ptr<JuliaScope> m(new JuliaScope);
+    m->inputs[JuliaScope::LEFT_INPUT].channels = 1;
+    m->inputs[JuliaScope::RIGHT_INPUT].channels = 1;
+    m->inputs[JuliaScope::RE_CV_INPUT].channels = 1;
+    m->inputs[JuliaScope::ZOOM_CV_INPUT].channels = 1;
+
+    int length = (int)(sampleRate * AUDIO_SECONDS);
+    // Scripted inputs: a tremolo tone on the left, a steady fifth on the right, slow CV
+    std::vector<float> left(length), right(length), reCv(length), zoomCv(length);
+    for (int i = 0; i < length; i++) {
+        float t = i / sampleRate;
+        float tremolo = 0.5f + 0.5f * std::sin(2.f * float(M_PI) * 0.7f * t);
+        left[i] = 5.f * tremolo * std::sin(2.f * float(M_PI) * 220.f * t);
+        right[i] = 3.f * std::sin(2.f * float(M_PI) * 330.f * t);
+        reCv[i] = std::sin(2.f * float(M_PI) * 0.3f * t);
+        zoomCv[i] = 2.f * t / AUDIO_SECONDS;
+    }
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < length; i++) {
+        m->inputs[JuliaScope::LEFT_INPUT].setVoltage(left[i]);
+        m->inputs[JuliaScope::RIGHT_INPUT].setVoltage(right[i]);
+        m->inputs[JuliaScope::RE_CV_INPUT].setVoltage(reCv[i]);
+        m->inputs[JuliaScope::ZOOM_CV_INPUT].setVoltage(zoomCv[i]);
+        m->process(makeArgs(sampleRate, i));
+
+        if (taps) {
+            // Let the pitch tracker catch up, so the estimates don't depend on thread timing
+            waitForPitch(m->pitchTracker);
+            m->renderState.update();
+            const JuliaParams& p = m->renderState.read();
+            (*taps)[0].process(i, p.cReal);
+            (*taps)[1].process(i, p.cImag);
+            (*taps)[2].process(i, p.zoom);
+            (*taps)[3].process(i, p.tilt);
+        }
+    }
+    double ns = elapsedNs(start);
+    if (counters)
+        m->processTimes.histogram.read(*counters);
+    return ns;
+}
+
+static void benchJuliaScope(Golden& golden) {
+    static const char* STATE_NAMES[] = {"cReal", "cImag", "zoom", "tilt"};
+
+    std::printf("JuliaScope::process, stereo input and CV connected\n");
+    std::printf("  %-8s %11s %10s %9s\n", "rate", "ns/sample", "self mean", "self p99");
+
+    for (float sampleRate : SAMPLE_RATES) {
+        int length = (int)(sampleRate * AUDIO_SECONDS);
+        PerfSummary counters;
+        double ns = runJuliaScope(sampleRate, nullptr, &counters);
+        std::printf("  %-8.0f %11.1f %10.1f %9.0f\n", sampleRate, ns / length, counters.mean, counters.p99);
+
+        std::vector<SampleTap> taps(4, SampleTap(length));
+        runJuliaScope(sampleRate, &taps);
+        for (int i = 0; i < 4; i++)
+            golden.addSamples(string::f("scope.%.0f.%s", sampleRate, STATE_NAMES[i]), taps[i].samples);
+    }
+    std::printf("\n");
+}
+
+// Pushes a stereo signal through the overlay pyramid, reading a snapshot once per 60 Hz UI
+// frame, and checks every bin of every level against the min/max of the raw samples
+static void benchScopeTrace(Golden& golden) {
+    std::printf("ScopeTrace, %d-sample pyramid with %d levels, read at 60 Hz\n",
+        ScopeTraceFrame::SAMPLES, ScopeTraceFrame::LEVELS);
+    std::printf("  %-8s %11s %10s %8s\n", "rate", "ns/sample", "snapshots", "bins");
+
+    for (float sampleRate : SAMPLE_RATES) {
+        int length = (int)(sampleRate * AUDIO_SECONDS);
+        int frameSamples = (int)(sampleRate / 60.f);
+        std::vector<float> left(length), right(length);
+        uint32_t noise = 1;
+        for (int i = 0; i < length; i++) {
+            noise = noise * 1664525u + 1013904223u;
+            float t = i / sampleRate;
+            left[i] = std::sin(2.f * float(M_PI) * 220.f * t) + 0.1f * ((noise >> 8) / 8388608.f - 1.f);
+            right[i] = std::sin(2.f * float(M_PI) * 331.f * t);
+        }
+
+        std::unique_ptr<ScopeTrace> trace(new ScopeTrace);
+        double ns = 0.0;
+        int snapshots = 0;
+        bool exact = true;
+        const ScopeTraceFrame* frame = nullptr;
+        for (int start = 0; start < length; start += frameSamples) {
+            int end = std::min(start + frameSamples, length);
+            Clock::time_point begin = Clock::now();
+            for (int i = start; i < end; i++)
+                trace->push(left[i], right[i], sampleRate);
+            ns += elapsedNs(begin);
+
+            frame = trace->acquire();
+            if (!frame)
+                continue;
+            snapshots++;
+            for (int k = 0; k < ScopeTraceFrame::LEVELS; k++) {
+                int binSamples = ScopeTraceFrame::BASE_SAMPLES << k;
+                uint32_t bins = frame->written >> k;
+                for (uint32_t b = bins - std::min(bins, (uint32_t)ScopeTraceFrame::levelSize(k)); b < bins; b++) {
+                    const ScopeTraceBin& bin = frame->bin(k, b);
+                    const float* l = &left[b * binSamples];
+                    const float* r = &right[b * binSamples];
+                    exact = exact && bin.minLeft == *std::min_element(l, l + binSamples)
+                        && bin.maxLeft == *std::max_element(l, l + binSamples)
+                        && bin.minRight == *std::min_element(r, r + binSamples)
+                        && bin.maxRight == *std::max_element(r, r + binSamples);
+                }
+            }
+        }
+        std::printf("  %-8.0f %11.2f %10d %8s\n", sampleRate, ns / length, snapshots, exact ? "exact" : "DIFFER");
+        golden.addChecksum(string::f("trace.%.0f", sampleRate), checksum((const uint8_t*)frame->bins, sizeof(frame->bins)));
+    }
+    std::printf("\n");
+}
+
+// Feeds the pitch tracker a harmonic-rich tone and reports the estimate, its error, and the
+// time from publishing a frame to the estimate being ready
+static void benchPitchTracker(Golden& golden) {
+    static const float FREQS[] = {30.f, 55.f, 110.f, 220.f, 440.f, 1000.f, 2500.f, 4500.f};
+    static const int HARMONICS = 8;
+    static const int REPEATS = 20;
+
+    std::printf("PitchTracker, %d-harmonic saw, %d-sample frames\n", HARMONICS, PitchTracker::FRAME_SIZE);
+    std::printf("  %-8s %8s %10s %8s %12s\n", "rate", "freq", "detected", "cents", "latency ms");
+
+    PitchTracker tracker;
+    std::vector<float> ring(PitchTracker::FRAME_SIZE);
+    for (float sampleRate : SAMPLE_RATES) {
+        std::vector<float> detected;
+        for (float freq : FREQS) {
+            for (int i = 0; i < PitchTracker::FRAME_SIZE; i++) {
+                double phase = 2.0 * M_PI * freq * i / sampleRate;
+                float v = 0.f;
+                for (int h = 1; h <= HARMONICS && h * freq < sampleRate / 2; h++)
+                    v += 0.5f * std::sin(h * phase) / h;
+                ring[i] = v;
+            }
+
+            PitchEstimate estimate;
+            double ns = 0.0;
+            for (int r = 0; r < REPEATS; r++) {
+                Clock::time_point start = Clock::now();
+                tracker.push(ring.data(), 0, sampleRate);
+                waitForPitch(tracker);
+                tracker.poll(estimate);
+                ns += elapsedNs(start);
+            }
+
+            float cents = 1200.f * std::log2(estimate.freq / freq);
+            std::printf("  %-8.0f %8.1f %10.2f %8.2f %12.3f\n", sampleRate, freq, estimate.freq,
+                estimate.voiced ? cents : NAN, ns / REPEATS / 1e6);
+            detected.push_back(estimate.voiced ? estimate.freq : 0.f);
+        }
+        golden.addSamples(string::f("pitch.%.0f", sampleRate), detected);
+    }
+    std::printf("\n");
+}
+
+static void benchJuliaRenderer(Golden& golden) {
+    static const int ITERATIONS[] = {16, 64, 256};
+    struct View {
+        const char* name;
+        float cReal, cImag, zoom, tilt;
+    };
+    static const View VIEWS[] = {
+        {"default", -0.7f, 0.27015f, 1.f, 0.f},
+        {"rabbit", -0.123f, 0.745f, 1.5f, 0.3f},
+    };
+
+    std::printf("JuliaRenderer, %dx%d, full frames (kernel: %s)\n", DISPLAY_WIDTH, DISPLAY_HEIGHT, getEscapeKernel().name);
+    std::printf("  %-8s %5s  %-6s %9s %12s\n", "view", "iter", "skip", "ms/frame", "Miter/frame");
+
+    JuliaRenderer renderer;
+    for (const View& view : VIEWS) {
+        for (int maxIter : ITERATIONS) {
+            for (int skip = 0; skip < 2; skip++) {
+                JuliaParams p;
+                p.cReal = view.cReal;
+                p.cImag = view.cImag;
+                p.zoom = view.zoom;
+                p.tilt = view.tilt;
+                p.maxIter = maxIter;
+
+                JuliaRenderOptions o;
+                o.progressive = false;
+                o.periodicity = skip;
+                o.boundaryTrace = skip;
+                o.temporalReuse = false;
+
+                double ns = 0.0;
+                for (int frame = 0; frame < RENDER_FRAMES; frame++) {
+                    Clock::time_point start = Clock::now();
+                    renderer.request(p, o);
+                    while (!renderer.acquireFrame())
+                        std::this_thread::yield();
+                    ns += elapsedNs(start);
+                }
+
+                const char* skipName = skip ? "on" : "off";
+                JuliaRenderStats stats = renderer.getStats();
+                std::printf("  %-8s %5d  %-6s %9.2f %12.2f\n", view.name, maxIter, skipName, ns / RENDER_FRAMES / 1e6, stats.iterations / 1e6);
+                golden.addChecksum(string::f("julia.%s.%d.skip-%s", view.name, maxIter, skipName),
+                    checksum(renderer.getPixels(), DISPLAY_WIDTH * DISPLAY_HEIGHT * 4));
+            }
+        }
+    }
+    std::printf("\n");
+}
+
+// Runs every escape kernel this CPU supports on the same points as the scalar fallback,
+// with and without periodicity checking, over display grids of several Julia sets plus
+// scattered points, an odd count so the vector kernels' scalar tails run too. Counts and
+// returned work must match exactly; any difference fails the golden check.
+static void benchEscapeKernels() {
+    static const int ITERATIONS[] = {16, 64, 256};
+    static const int SCATTERED = 1003;
+    struct Set {
+        const char* name;
+        float cReal, cImag;
+    };
+    static const Set SETS[] = {
+        {"default", -0.7f, 0.27015f},
+        {"rabbit", -0.123f, 0.745f},
+        {"basilica", -1.f, 0.f},
+        {"dust", 0.3f, 0.5f},
+    };
+
+    const std::vector<EscapeKernel>& kernels = getSupportedEscapeKernels();
+    const EscapeKernel& scalar = kernels.back();
+    std::printf("Escape kernels against %s, %dx%d grid plus %d scattered points, %d Julia sets\n", scalar.name,
+        DISPLAY_WIDTH, DISPLAY_HEIGHT, SCATTERED, (int)(sizeof(SETS) / sizeof(SETS[0])));
+    std::printf("  %-8s %5s  %-6s %14s %14s\n", "kernel", "iter", "period", "counts differ", "work differs");
+
+    JuliaParams p;
+    JuliaView view(p, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0.0, 0.0);
+    std::vector<float> x, y;
+    for (int py = 0; py < DISPLAY_HEIGHT; py++) {
+        for (int px = 0; px < DISPLAY_WIDTH; px++) {
+            x.push_back(view.x(px));
+            y.push_back(view.y(py));
+        }
+    }
+    uint32_t seed = 12345;
+    for (int i = 0; i < 2 * SCATTERED; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float v = (seed >> 8) / 16777216.f * 4.f - 2.f;
+        (i % 2 ? y : x).push_back(v);
+    }
+    int count = (int)x.size();
+    std::vector<int32_t> expected(count), iters(count);
+
+    for (const EscapeKernel& kernel : kernels) {
+        if (&kernel == &scalar)
+            continue;
+        for (int maxIter : ITERATIONS) {
+            for (int periodicity = 0; periodicity < 2; periodicity++) {
+                int countsDiffer = 0;
+                int workDiffers = 0;
+                for (const Set& set : SETS) {
+                    uint64_t expectedWork = scalar.escape(x.data(), y.data(), count, set.cReal, set.cImag, maxIter, periodicity, expected.data());
+                    uint64_t work = kernel.escape(x.data(), y.data(), count, set.cReal, set.cImag, maxIter, periodicity, iters.data());
+                    for (int i = 0; i < count; i++)
+                        countsDiffer += iters[i] != expected[i];
+                    workDiffers += work != expectedWork;
+                }
+                kernelMismatches += countsDiffer + workDiffers;
+                std::printf("  %-8s %5d  %-6s %14d %14d\n", kernel.name, maxIter, periodicity ? "on" : "off", countsDiffer, workDiffers);
+            }
+        }
+    }
+    std::printf("\n");
+}
+
+// Zooms into the rabbit to the renderer's limit. Times full frames, and checks the counts
+// of the perturbation kernels against plain double-precision iteration, next to what
+// plain float iteration would give at the same zoom.
+static void benchJuliaDeepZoom(Golden& golden) {
+    static const int OCTAVES[] = {6, 12, 20, 30, 40};
+    static const int MAX_ITER = 256;
+    const float cReal = -0.123f;
+    const float cImag = 0.745f;
+
+    std::printf("JuliaRenderer deep zoom, rabbit at %d iterations\n", MAX_ITER);
+    std::printf("  %-6s %9s %12s %15s %15s %8s\n", "zoom", "ms/frame", "Miter/frame", "perturb differ", "float differ", "kernels");
+
+    double targetX, targetY;
+    juliaZoomTarget(cReal, cImag, targetX, targetY);
+
+    JuliaRenderer renderer;
+    for (int octaves : OCTAVES) {
+        JuliaParams p;
+        p.cReal = cReal;
+        p.cImag = cImag;
+        p.zoom = std::exp2((float)octaves);
+        p.maxIter = MAX_ITER;
+
+        JuliaRenderOptions o;
+        o.progressive = false;
+        o.temporalReuse = false;
+
+        double ns = 0.0;
+        for (int frame = 0; frame < RENDER_FRAMES; frame++) {
+            Clock::time_point start = Clock::now();
+            renderer.request(p, o);
+            while (!renderer.acquireFrame())
+                std::this_thread::yield();
+            ns += elapsedNs(start);
+        }
+        JuliaRenderStats stats = renderer.getStats();
+        golden.addChecksum(string::f("julia.deep.%d", octaves), checksum(renderer.getPixels(), DISPLAY_WIDTH * DISPLAY_HEIGHT * 4));
+
+        // Every pixel, without periodicity or boundary tracing, so each count is a plain escape time
+        JuliaView view(p, DISPLAY_WIDTH, DISPLAY_HEIGHT, targetX, targetY);
+        JuliaReference reference;
+        reference.compute(view.centerX, view.centerY, cReal, cImag, MAX_ITER, (view.xMax - view.xMin) / DISPLAY_WIDTH);
+        int pixels = DISPLAY_WIDTH * DISPLAY_HEIGHT;
+        std::vector<float> dx(pixels), dy(pixels), x(pixels), y(pixels);
+        std::vector<int32_t> exact(pixels), perturbed(pixels), direct(pixels), other(pixels);
+        for (int py = 0; py < DISPLAY_HEIGHT; py++) {
+            for (int px = 0; px < DISPLAY_WIDTH; px++) {
+                int i = py * DISPLAY_WIDTH + px;
+                dx[i] = view.x(px);
+                dy[i] = view.y(py);
+                double zx = view.centerX + dx[i];
+                double zy = view.centerY + dy[i];
+                x[i] = (float)zx;
+                y[i] = (float)zy;
+                int iter = 0;
+                while (zx * zx + zy * zy <= 4.0 && iter < MAX_ITER) {
+                    double zxTemp = zx * zx - zy * zy + cReal;
+                    zy = 2.0 * zx * zy + cImag;
+                    zx = zxTemp;
+                    iter++;
+                }
+                exact[i] = iter;
+            }
+        }
+        getEscapeKernel().perturb(dx.data(), dy.data(), pixels, reference, MAX_ITER, false, perturbed.data());
+        getEscapeKernel().escape(x.data(), y.data(), pixels, cReal, cImag, MAX_ITER, false, direct.data());
+
+        // Every instruction set must give the same counts, with and without periodicity
+        bool agree = true;
+        for (int periodicity = 0; periodicity < 2; periodicity++) {
+            std::vector<int32_t> expected(pixels);
+            getSupportedEscapeKernels().back().perturb(dx.data(), dy.data(), pixels, reference, MAX_ITER, periodicity, expected.data());
+            for (const EscapeKernel& kernel : getSupportedEscapeKernels()) {
+                kernel.perturb(dx.data(), dy.data(), pixels, reference, MAX_ITER, periodicity, other.data());
+                agree = agree && other == expected;
+            }
+        }
+        kernelMismatches += !agree;
+
+        int perturbDiffer = 0;
+        int directDiffer = 0;
+        for (int i = 0; i < pixels; i++) {
+            perturbDiffer += perturbed[i] != exact[i];
+            directDiffer += direct[i] != exact[i];
+        }
+        std::printf("  2^%-4d %9.2f %12.2f %14.3f%% %14.3f%% %8s\n", octaves, ns / RENDER_FRAMES / 1e6, stats.iterations / 1e6,
+            100.0 * perturbDiffer / pixels, 100.0 * directDiffer / pixels, agree ? "agree" : "DIFFER");
+    }
+    std::printf("\n");
+}
+
+// Renders a slow, audio-like sweep of c with and without temporal reuse, and compares
+// each reused frame with the same frame computed from scratch
+static void benchJuliaReuse(Golden& golden) {
+    static const float SPEEDS[] = {0.0005f, 0.002f, 0.008f};
+    static const int FRAMES = 64;
+
+    std::printf("JuliaRenderer temporal reuse, rabbit at 256 iterations, %d frames\n", FRAMES);
+    std::printf("  %-7s %-6s %9s %12s %14s %8s\n", "dc", "reuse", "ms/frame", "Miter/frame", "pixels differ", "upload");
+
+    JuliaRenderer reference;
+    for (float speed : SPEEDS) {
+        for (int reuse = 0; reuse < 2; reuse++) {
+            // A new renderer, so the first frame has nothing to reuse
+            JuliaRenderer renderer;
+            double ns = 0.0;
+            uint64_t iterations = 0;
+            int differing = 0;
+            // Dirty rectangle area, the texture upload a display makes for the frame
+            uint64_t dirty = 0;
+            uint64_t hash = 0;
+            for (int frame = 0; frame < FRAMES; frame++) {
+                // c moves about speed per frame, like an envelope under the MOD knob
+                JuliaParams p;
+                p.cReal = -0.123f + speed * frame;
+                p.cImag = 0.745f + 0.5f * speed * frame;
+                p.zoom = 1.5f;
+                p.tilt = 0.3f;
+                p.maxIter = 256;
+                JuliaRenderOptions o;
+                o.progressive = false;
+                o.temporalReuse = reuse;
+
+                renderer.request(p, o);
+                while (!renderer.acquireFrame())
+                    std::this_thread::yield();
+                // Worker time only; the handoff to this thread is the same either way
+                ns += renderer.getStats().frameNs;
+                iterations += renderer.getStats().iterations;
+                const JuliaFrame& shown = renderer.getFrame();
+                dirty += shown.dirtyWidth * shown.dirtyHeight;
+
+                if (reuse) {
+                    o.temporalReuse = false;
+                    reference.request(p, o);
+                    while (!reference.acquireFrame())
+                        std::this_thread::yield();
+                    const uint8_t* a = renderer.getPixels();
+                    const uint8_t* b = reference.getPixels();
+                    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++)
+                        differing += std::memcmp(a + 4 * i, b + 4 * i, 4) != 0;
+                }
+                hash ^= checksum(renderer.getPixels(), DISPLAY_WIDTH * DISPLAY_HEIGHT * 4) + frame;
+            }
+
+            std::printf("  %-7.4f %-6s %9.2f %12.3f %13.3f%% %7.1f%%\n", speed, reuse ? "on" : "off", ns / FRAMES / 1e6,
+                iterations / 1e6 / FRAMES, 100.0 * differing / (FRAMES * DISPLAY_WIDTH * DISPLAY_HEIGHT),
+                100.0 * dirty / (FRAMES * DISPLAY_WIDTH * DISPLAY_HEIGHT));
+            if (reuse)
+                golden.addChecksum(string::f("julia.reuse.%.4f", speed), hash);
+        }
+    }
+    std::printf("\n");
+}
+
+// Records JuliaScope at a fixed frame rate through its display, while the audio runs
+// faster than real time, and checks that every frame due arrives on disk in order. The
+// PPM sequence only depends on the audio, so its files go into the golden file. Times
+// are wall time for the whole run, audio processing included.
+static void benchJuliaRecording(Golden& golden) {
+    static const float SAMPLE_RATE = 48000.f;
+    static const float FPS = 30.f;
+    static const char* FORMAT_NAMES[] = {"ppm", "raw"};
+
+    std::printf("JuliaScope recording, %.0f fps for %.0f s of audio at %.0f Hz\n", FPS, AUDIO_SECONDS, SAMPLE_RATE);
+    std::printf("  %-6s %7s %8s %9s %9s %8s\n", "format", "frames", "dropped", "ms/frame", "MB", "MB/s");
+
+    int length = (int)(SAMPLE_RATE * AUDIO_SECONDS);
+    for (int format = 0; format < FRAME_FORMATS_LEN; format++) {
+        std::unique_ptr<JuliaScope> m(new JuliaScope);
+        m->inputs[JuliaScope::LEFT_INPUT].channels = 1;
+        m->recordRate = FPS;
+        m->recordFormat = format;
+        std::unique_ptr<JuliaScopeDisplay> display(new JuliaScopeDisplay);
+        display->module = m.get();
+
+        std::string directory = asset::user(string::f("recording-%s", FORMAT_NAMES[format]));
+        std::string error;
+        if (!display->startRecording(directory, error)) {
+            std::printf("  %-6s %s\n", FORMAT_NAMES[format], error.c_str());
+            continue;
+        }
+
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < length; i++) {
+            float t = i / SAMPLE_RATE;
+            float tremolo = 0.5f + 0.5f * std::sin(2.f * float(M_PI) * 0.7f * t);
+            m->inputs[JuliaScope::LEFT_INPUT].setVoltage(5.f * tremolo * std::sin(2.f * float(M_PI) * 220.f * t));
+            m->process(makeArgs(SAMPLE_RATE, i));
+            // Let the pitch tracker catch up, so the tilt doesn't depend on thread timing
+            waitForPitch(m->pitchTracker);
+        }
+        // Stopping skips the frames still queued, so let the sequencer render them all first
+        uint32_t due = (uint32_t)(AUDIO_SECONDS * FPS) + 1;
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(30);
+        while (display->recorder.getWritten() + m->recordOverflows.load() < due && !display->recorder.hasFailed()
+            && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        display->stopRecording();
+        double ns = elapsedNs(start);
+
+        uint32_t frames = display->recorder.getWritten();
+        uint32_t dropped = display->recorder.getDropped() + m->recordOverflows.load();
+        double mb = display->recorder.getBytes() / 1e6;
+        std::printf("  %-6s %7u %8u %9.2f %9.1f %8.0f\n", FORMAT_NAMES[format], frames, dropped,
+            ns / std::max(frames, 1u) / 1e6, mb, mb / (ns / 1e9));
+
+        // One line per frame due, numbered from 0 at time number / FPS
+        std::vector<uint8_t> index = system::readFile(system::join(directory, "index.csv"));
+        std::istringstream lines(std::string(index.begin(), index.end()));
+        std::string line;
+        std::getline(lines, line);
+        uint32_t expected = 0;
+        uint64_t hash = 0;
+        while (std::getline(lines, line)) {
+            unsigned number;
+            double time;
+            char name[64];
+            if (std::sscanf(line.c_str(), "%u,%lf,%*d,%*d,%63s", &number, &time, name) != 3
+                || number != expected || std::abs(time - number / FPS) > 1e-6) {
+                std::printf("  bad index line: %s\n", line.c_str());
+                break;
+            }
+            std::vector<uint8_t> file = system::readFile(system::join(directory, name));
+            hash ^= checksum(file.data(), file.size()) + number;
+            expected++;
+        }
+        if (expected != due)
+            std::printf("  %u frames indexed, %u due\n", expected, due);
+        if (format == FRAME_FORMAT_PPM)
+            golden.addChecksum("record.ppm", hash);
+    }
+    std::printf("\n");
+}
+
+// Animates several scopes at once, each with its own renderer and governor, the way the
+// display widgets drive them, and reports where the governors settle. Timing dependent,
+// so nothing here goes into the golden file.
+static void benchJuliaGovernor() {
+    static const int SCOPES[] = {1, 4};
+    static const float BUDGETS[] = {0.f, 0.5f, 2.f};
+    static const int UI_FRAMES = 150;
+    // Stand-in for the UI frame interval, shorter than a real one to keep the run brief
+    static const int UI_FRAME_US = 2000;
+
+    std::printf("JuliaGovernor, rabbit at 256 iterations, c moving every frame, %d render workers\n",
+        juliaScheduler.getWorkerCount());
+    std::printf("  %6s %9s %8s %11s %9s %9s %9s\n", "scopes", "budget", "quality", "ms/frame", "p99 ms", "frames", "dropped");
+
+    for (int scopes : SCOPES) {
+        for (float budget : BUDGETS) {
+            std::vector<std::unique_ptr<JuliaRenderer>> renderers;
+            std::vector<JuliaGovernor> governors(scopes);
+            std::vector<int> skips(scopes, 0);
+            for (int i = 0; i < scopes; i++) {
+                renderers.emplace_back(new JuliaRenderer);
+                governors[i].budgetMs = budget;
+            }
+
+            for (int frame = 0; frame < UI_FRAMES; frame++) {
+                for (int i = 0; i < scopes; i++) {
+                    renderers[i]->acquireFrame();
+                    governors[i].update(renderers[i]->getStats());
+                    if (++skips[i] < governors[i].getQuality().frameSkip)
+                        continue;
+                    skips[i] = 0;
+
+                    JuliaParams p;
+                    p.cReal = -0.123f + 0.01f * std::sin(0.1f * frame + i);
+                    p.cImag = 0.745f;
+                    p.zoom = 1.5f;
+                    p.maxIter = 256;
+                    JuliaRenderOptions o;
+                    governors[i].apply(p, o);
+                    renderers[i]->request(p, o);
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(UI_FRAME_US));
+            }
+
+            float ms = 0.f;
+            std::string p99 = "-";
+            float worstP99 = 0.f;
+            int level = 0;
+            uint32_t frames = 0;
+            uint32_t dropped = 0;
+            for (int i = 0; i < scopes; i++) {
+                ms += governors[i].getAverageMs() / scopes;
+                level = std::max(level, governors[i].getLevel());
+                frames += renderers[i]->getStats().frames;
+                dropped += renderers[i]->getStats().dropped;
+                PerfSummary frameTimes;
+                if (renderers[i]->getFrameTimes(frameTimes)) {
+                    worstP99 = std::max(worstP99, frameTimes.p99 * 1e-6f);
+                    p99 = string::f("%.2f", worstP99);
+                }
+            }
+            std::printf("  %6d %9s %5d/%d %11.2f %9s %9u %9u\n", scopes, budget > 0.f ? string::f("%.1f ms", budget).c_str() : "none",
+                JuliaGovernor::LEVEL_COUNT - level, JuliaGovernor::LEVEL_COUNT, ms, p99.c_str(), frames, dropped);
+        }
+    }
+    std::printf("\n");
+}
+
+int main(int argc, char** argv) {
+    std::string writePath, checkPath;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--write") && i + 1 < argc)
+            writePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--check") && i + 1 < argc)
+            checkPath = argv[++i];
+        else {
+            std::fprintf(stderr, "usage: %s [--write FILE | --check FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Starts the shared JuliaScope render workers, sized to this machine as in Rack
+    static Plugin plugin;
+    plugin.slug = "TonyVCO";
+    init(&plugin);
+
+    Golden golden;
+    benchWavetable(golden);
+    benchSimpleVCO(golden);
+    benchJuliaScope(golden);
+    benchScopeTrace(golden);
+    benchPitchTracker(golden);
+    benchJuliaRenderer(golden);
+    benchEscapeKernels();
+    benchJuliaDeepZoom(golden);
+    benchJuliaReuse(golden);
+    benchJuliaRecording(golden);
+    benchJuliaGovernor();
+
+    if (!writePath.empty()) {
+        if (!golden.write(writePath)) {
+            std::fprintf(stderr, "cannot write %s\n", writePath.c_str());
+            return 2;
+        }
+        std::printf("Wrote %zu golden signals to %s\n", golden.order.size(), writePath.c_str());
+    }
+
+    if (!checkPath.empty()) {
+        Golden expected;
+        if (!expected.read(checkPath)) {
+            std::fprintf(stderr, "cannot read %s\n", checkPath.c_str());
+            return 2;
+        }
+        int mismatches = golden.compare(expected);
+        std::printf("%d of %zu golden signals changed\n", mismatches, expected.order.size());
+        std::printf("%d kernel mismatches\n", kernelMismatches);
+        if (mismatches > 0 || kernelMismatches > 0)
+            return 1;
+    }
+    return 0;
+}
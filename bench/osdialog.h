@@ -0,0 +1,27 @@
+#pragma once
+// Stand-in for the osdialog API bundled with the Rack SDK. The benchmark never opens a dialog.
+
+typedef enum {
+    OSDIALOG_INFO,
+    OSDIALOG_WARNING,
+    OSDIALOG_ERROR,
+} osdialog_message_level;
+
+typedef enum {
+    OSDIALOG_OK,
+    OSDIALOG_OK_CANCEL,
+    OSDIALOG_YES_NO,
+} osdialog_message_buttons;
+
+typedef enum {
+    OSDIALOG_OPEN,
+    OSDIALOG_OPEN_DIR,
+    OSDIALOG_SAVE,
+} osdialog_file_action;
+
+typedef struct osdialog_filters osdialog_filters;
+
+inline int osdialog_message(osdialog_message_level level, osdialog_message_buttons buttons, const char* message) { return 0; }
+inline char* osdialog_file(osdialog_file_action action, const char* dir, const char* filename, osdialog_filters* filters) { return nullptr; }
+inline osdialog_filters* osdialog_filters_parse(const char* str) { return nullptr; }
+inline void osdialog_filters_free(osdialog_filters* filters) {}
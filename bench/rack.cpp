@@ -0,0 +1,165 @@
+#include <rack.hpp>
+#include <cstdarg>
+#include <cstdio>
+#include <cerrno>
+#include <sys/stat.h>
+#include <dirent.h>
+
+// No-op definitions for the stand-in API. Nothing the benchmark runs draws or saves; only
+// the file functions the wavetable cache uses do real work, inside BENCH_USER_DIR.
+
+#ifndef BENCH_USER_DIR
+#define BENCH_USER_DIR "/tmp/tonyvco-bench-user"
+#endif
+
+json_t* json_object() { return nullptr; }
+json_t* json_boolean(bool value) { return nullptr; }
+json_t* json_integer(long long value) { return nullptr; }
+json_t* json_real(double value) { return nullptr; }
+json_t* json_string(const char* value) { return nullptr; }
+json_t* json_object_get(const json_t* object, const char* key) { return nullptr; }
+int json_object_set_new(json_t* object, const char* key, json_t* value) { return 0; }
+bool json_boolean_value(const json_t* json) { return false; }
+long long json_integer_value(const json_t* json) { return 0; }
+double json_real_value(const json_t* json) { return 0.0; }
+double json_number_value(const json_t* json) { return 0.0; }
+const char* json_string_value(const json_t* json) { return ""; }
+void json_decref(json_t* json) {}
+int json_dump_file(const json_t* json, const char* path, size_t flags) { return -1; }
+
+int nvgCreateImageRGBA(NVGcontext* vg, int w, int h, int imageFlags, const unsigned char* data) { return 0; }
+void nvgUpdateImage(NVGcontext* vg, int image, const unsigned char* data) {}
+void nvgDeleteImage(NVGcontext* vg, int image) {}
+void nvgCurrentTransform(NVGcontext* vg, float* xform) {
+    const float identity[6] = {1.f, 0.f, 0.f, 1.f, 0.f, 0.f};
+    std::copy(identity, identity + 6, xform);
+}
+unsigned int nvglImageHandleGL2(NVGcontext* vg, int image) { return 0; }
+void glGetIntegerv(GLenum pname, GLint* data) { *data = 0; }
+void glBindTexture(GLenum target, GLuint texture) {}
+void glPixelStorei(GLenum pname, GLint param) {}
+void glTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, const void* pixels) {}
+NVGpaint nvgImagePattern(NVGcontext* vg, float ox, float oy, float ex, float ey, float angle, int image, float alpha) { return NVGpaint(); }
+void nvgBeginPath(NVGcontext* vg) {}
+void nvgRect(NVGcontext* vg, float x, float y, float w, float h) {}
+void nvgMoveTo(NVGcontext* vg, float x, float y) {}
+void nvgLineTo(NVGcontext* vg, float x, float y) {}
+void nvgFill(NVGcontext* vg) {}
+void nvgStroke(NVGcontext* vg) {}
+void nvgFillColor(NVGcontext* vg, NVGcolor color) {}
+void nvgFillPaint(NVGcontext* vg, NVGpaint paint) {}
+void nvgStrokeColor(NVGcontext* vg, NVGcolor color) {}
+void nvgStrokeWidth(NVGcontext* vg, float size) {}
+void nvgFontSize(NVGcontext* vg, float size) {}
+void nvgFontFaceId(NVGcontext* vg, int font) {}
+void nvgTextAlign(NVGcontext* vg, int align) {}
+float nvgText(NVGcontext* vg, float x, float y, const char* string, const char* end) { return x; }
+NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b) { return nvgRGBA(r, g, b, 255); }
+NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {
+    NVGcolor color = {r / 255.f, g / 255.f, b / 255.f, a / 255.f};
+    return color;
+}
+NVGcolor nvgTransRGBA(NVGcolor c0, unsigned char a) {
+    c0.a = a / 255.f;
+    return c0;
+}
+
+namespace rack {
+
+Context* contextGet() {
+    static window::Window window;
+    static engine::Engine engine;
+    static Context context = {&window, &engine};
+    return &context;
+}
+
+app::SvgPanel* createPanel(std::string svgPath) { return new app::SvgPanel; }
+
+ui::MenuItem* createIndexSubmenuItem(std::string text, std::vector<std::string> labels, std::function<size_t()> getter,
+    std::function<void(size_t)> setter, bool disabled, bool alwaysConsume) {
+    return new ui::MenuItem;
+}
+
+ui::MenuItem* createMenuItem(std::string text, std::string rightText, std::function<void()> action, bool disabled,
+    bool alwaysConsume) {
+    return new ui::MenuItem;
+}
+
+namespace asset {
+std::string plugin(plugin::Plugin* plugin, std::string filename) { return filename; }
+std::string user(std::string filename) { return system::join(BENCH_USER_DIR, filename); }
+} // namespace asset
+
+namespace system {
+void setThreadName(const std::string& name) {}
+
+std::string join(const std::string& path1, const std::string& path2) { return path1 + "/" + path2; }
+
+bool createDirectories(const std::string& path) {
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string dir = path.substr(0, pos);
+        if (mkdir(dir.c_str(), 0755) && errno != EEXIST)
+            return false;
+        if (pos == std::string::npos)
+            return true;
+    }
+}
+
+std::vector<uint8_t> readFile(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        throw Exception("Cannot read file " + path);
+    std::vector<uint8_t> data;
+    uint8_t buffer[65536];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0)
+        data.insert(data.end(), buffer, buffer + n);
+    std::fclose(f);
+    return data;
+}
+
+void writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f)
+        throw Exception("Cannot write file " + path);
+    size_t written = std::fwrite(data.data(), 1, data.size(), f);
+    std::fclose(f);
+    if (written != data.size())
+        throw Exception("Cannot write file " + path);
+}
+
+bool rename(const std::string& srcPath, const std::string& destPath) { return std::rename(srcPath.c_str(), destPath.c_str()) == 0; }
+bool remove(const std::string& path) { return std::remove(path.c_str()) == 0; }
+std::string getFilename(const std::string& path) { return path.substr(path.rfind('/') + 1); }
+
+std::vector<std::string> getEntries(const std::string& dirPath) {
+    std::vector<std::string> entries;
+    DIR* dir = opendir(dirPath.c_str());
+    if (!dir)
+        return entries;
+    while (struct dirent* entry = readdir(dir)) {
+        if (std::strcmp(entry->d_name, ".") && std::strcmp(entry->d_name, ".."))
+            entries.push_back(join(dirPath, entry->d_name));
+    }
+    closedir(dir);
+    return entries;
+}
+
+uint64_t getFileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) ? 0 : st.st_size;
+}
+} // namespace system
+
+namespace string {
+std::string f(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    char buffer[1024];
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return buffer;
+}
+} // namespace string
+
+} // namespace rack
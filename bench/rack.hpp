@@ -0,0 +1,535 @@
+// Minimal stand-in for the parts of the Rack SDK the plugin sources use, so the
+// modules can be built and run headless by the benchmark. Module, Param and Port
+// behave like Rack's; widgets, NanoVG and jansson calls compile but do nothing.
+#pragma once
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <immintrin.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// jansson
+typedef struct json_t json_t;
+json_t* json_object();
+json_t* json_boolean(bool value);
+json_t* json_integer(long long value);
+json_t* json_real(double value);
+json_t* json_string(const char* value);
+json_t* json_object_get(const json_t* object, const char* key);
+int json_object_set_new(json_t* object, const char* key, json_t* value);
+bool json_boolean_value(const json_t* json);
+long long json_integer_value(const json_t* json);
+double json_real_value(const json_t* json);
+double json_number_value(const json_t* json);
+const char* json_string_value(const json_t* json);
+void json_decref(json_t* json);
+#define JSON_INDENT(n) ((n) & 0x1F)
+int json_dump_file(const json_t* json, const char* path, size_t flags);
+
+// NanoVG
+struct NVGcontext;
+struct NVGcolor { float r, g, b, a; };
+struct NVGpaint { float xform[6]; };
+enum { NVG_ALIGN_LEFT = 1, NVG_ALIGN_CENTER = 2, NVG_ALIGN_MIDDLE = 16, NVG_IMAGE_NEAREST = 32 };
+int nvgCreateImageRGBA(NVGcontext* vg, int w, int h, int imageFlags, const unsigned char* data);
+void nvgUpdateImage(NVGcontext* vg, int image, const unsigned char* data);
+void nvgDeleteImage(NVGcontext* vg, int image);
+NVGpaint nvgImagePattern(NVGcontext* vg, float ox, float oy, float ex, float ey, float angle, int image, float alpha);
+void nvgBeginPath(NVGcontext* vg);
+void nvgRect(NVGcontext* vg, float x, float y, float w, float h);
+void nvgMoveTo(NVGcontext* vg, float x, float y);
+void nvgLineTo(NVGcontext* vg, float x, float y);
+void nvgFill(NVGcontext* vg);
+void nvgStroke(NVGcontext* vg);
+void nvgFillColor(NVGcontext* vg, NVGcolor color);
+void nvgFillPaint(NVGcontext* vg, NVGpaint paint);
+void nvgStrokeColor(NVGcontext* vg, NVGcolor color);
+void nvgStrokeWidth(NVGcontext* vg, float size);
+void nvgFontSize(NVGcontext* vg, float size);
+void nvgFontFaceId(NVGcontext* vg, int font);
+void nvgTextAlign(NVGcontext* vg, int align);
+float nvgText(NVGcontext* vg, float x, float y, const char* string, const char* end);
+NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b);
+NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+NVGcolor nvgTransRGBA(NVGcolor c0, unsigned char a);
+void nvgCurrentTransform(NVGcontext* vg, float* xform);
+unsigned int nvglImageHandleGL2(NVGcontext* vg, int image);
+
+// OpenGL, as Rack's window header includes it
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+enum {
+    GL_TEXTURE_2D = 0x0DE1, GL_TEXTURE_BINDING_2D = 0x8069, GL_RGBA = 0x1908, GL_UNSIGNED_BYTE = 0x1401,
+    GL_UNPACK_ALIGNMENT = 0x0CF5, GL_UNPACK_ROW_LENGTH = 0x0CF2, GL_UNPACK_SKIP_PIXELS = 0x0CF4, GL_UNPACK_SKIP_ROWS = 0x0CF3,
+};
+void glGetIntegerv(GLenum pname, GLint* data);
+void glBindTexture(GLenum target, GLuint texture);
+void glPixelStorei(GLenum pname, GLint param);
+void glTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, const void* pixels);
+
+namespace rack {
+
+template <typename T>
+T clamp(T x, T a, T b) { return std::max(std::min(x, b), a); }
+
+namespace math {
+struct Vec {
+    float x = 0.f;
+    float y = 0.f;
+    Vec() {}
+    Vec(float x, float y) : x(x), y(y) {}
+    Vec mult(float s) const { return Vec(x * s, y * s); }
+    Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+};
+struct Rect {
+    Vec pos;
+    Vec size;
+};
+} // namespace math
+using namespace math;
+
+inline float mm2px(float mm) { return mm * 75.f / 25.4f; }
+inline Vec mm2px(Vec mm) { return mm.mult(75.f / 25.4f); }
+
+// SSE float_4 and int32_4 with Rack's operators and math functions
+namespace simd {
+
+template <typename T, int N>
+struct Vector;
+
+template <>
+struct Vector<int32_t, 4>;
+
+template <>
+struct Vector<float, 4> {
+    union {
+        __m128 v;
+        float s[4];
+    };
+    Vector() = default;
+    Vector(__m128 v) : v(v) {}
+    Vector(float x) { v = _mm_set1_ps(x); }
+    Vector(float a, float b, float c, float d) { v = _mm_setr_ps(a, b, c, d); }
+    inline Vector(Vector<int32_t, 4> a);
+    static Vector zero() { return Vector(_mm_setzero_ps()); }
+    static Vector mask() { return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1))); }
+    static Vector load(const float* x) { return Vector(_mm_loadu_ps(x)); }
+    void store(float* x) { _mm_storeu_ps(x, v); }
+    static inline Vector cast(Vector<int32_t, 4> a);
+    float& operator[](int i) { return s[i]; }
+    const float& operator[](int i) const { return s[i]; }
+};
+
+template <>
+struct Vector<int32_t, 4> {
+    union {
+        __m128i v;
+        int32_t s[4];
+    };
+    Vector() = default;
+    Vector(__m128i v) : v(v) {}
+    Vector(int32_t x) { v = _mm_set1_epi32(x); }
+    Vector(int32_t a, int32_t b, int32_t c, int32_t d) { v = _mm_setr_epi32(a, b, c, d); }
+    Vector(Vector<float, 4> a) { v = _mm_cvttps_epi32(a.v); }
+    static Vector zero() { return Vector(_mm_setzero_si128()); }
+    static Vector mask() { return Vector(_mm_set1_epi32(-1)); }
+    static Vector load(const int32_t* x) { return Vector(_mm_loadu_si128((const __m128i*)x)); }
+    void store(int32_t* x) { _mm_storeu_si128((__m128i*)x, v); }
+    static Vector cast(Vector<float, 4> a) { return Vector(_mm_castps_si128(a.v)); }
+    int32_t& operator[](int i) { return s[i]; }
+    const int32_t& operator[](int i) const { return s[i]; }
+};
+
+inline Vector<float, 4>::Vector(Vector<int32_t, 4> a) { v = _mm_cvtepi32_ps(a.v); }
+inline Vector<float, 4> Vector<float, 4>::cast(Vector<int32_t, 4> a) { return Vector(_mm_castsi128_ps(a.v)); }
+
+typedef Vector<float, 4> float_4;
+typedef Vector<int32_t, 4> int32_4;
+
+inline float_4 operator+(float_4 a, float_4 b) { return _mm_add_ps(a.v, b.v); }
+inline float_4 operator-(float_4 a, float_4 b) { return _mm_sub_ps(a.v, b.v); }
+inline float_4 operator*(float_4 a, float_4 b) { return _mm_mul_ps(a.v, b.v); }
+inline float_4 operator/(float_4 a, float_4 b) { return _mm_div_ps(a.v, b.v); }
+inline float_4 operator&(float_4 a, float_4 b) { return _mm_and_ps(a.v, b.v); }
+inline float_4 operator|(float_4 a, float_4 b) { return _mm_or_ps(a.v, b.v); }
+inline float_4 operator^(float_4 a, float_4 b) { return _mm_xor_ps(a.v, b.v); }
+inline float_4 operator==(float_4 a, float_4 b) { return _mm_cmpeq_ps(a.v, b.v); }
+inline float_4 operator!=(float_4 a, float_4 b) { return _mm_cmpneq_ps(a.v, b.v); }
+inline float_4 operator<(float_4 a, float_4 b) { return _mm_cmplt_ps(a.v, b.v); }
+inline float_4 operator>(float_4 a, float_4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline float_4 operator<=(float_4 a, float_4 b) { return _mm_cmple_ps(a.v, b.v); }
+inline float_4 operator>=(float_4 a, float_4 b) { return _mm_cmpge_ps(a.v, b.v); }
+inline float_4 operator-(float_4 a) { return 0.f - a; }
+inline float_4 operator~(float_4 a) { return a ^ float_4::mask(); }
+inline float_4& operator+=(float_4& a, float_4 b) { return a = a + b; }
+inline float_4& operator-=(float_4& a, float_4 b) { return a = a - b; }
+inline float_4& operator*=(float_4& a, float_4 b) { return a = a * b; }
+inline float_4& operator/=(float_4& a, float_4 b) { return a = a / b; }
+inline float_4& operator&=(float_4& a, float_4 b) { return a = a & b; }
+inline float_4& operator|=(float_4& a, float_4 b) { return a = a | b; }
+inline float_4& operator^=(float_4& a, float_4 b) { return a = a ^ b; }
+
+inline int32_4 operator+(int32_4 a, int32_4 b) { return _mm_add_epi32(a.v, b.v); }
+inline int32_4 operator-(int32_4 a, int32_4 b) { return _mm_sub_epi32(a.v, b.v); }
+inline int32_4 operator&(int32_4 a, int32_4 b) { return _mm_and_si128(a.v, b.v); }
+inline int32_4 operator|(int32_4 a, int32_4 b) { return _mm_or_si128(a.v, b.v); }
+inline int32_4 operator^(int32_4 a, int32_4 b) { return _mm_xor_si128(a.v, b.v); }
+inline int32_4 operator==(int32_4 a, int32_4 b) { return _mm_cmpeq_epi32(a.v, b.v); }
+inline int32_4 operator<(int32_4 a, int32_4 b) { return _mm_cmplt_epi32(a.v, b.v); }
+inline int32_4 operator>(int32_4 a, int32_4 b) { return _mm_cmpgt_epi32(a.v, b.v); }
+inline int32_4 operator<<(int32_4 a, int b) { return _mm_slli_epi32(a.v, b); }
+inline int32_4 operator>>(int32_4 a, int b) { return _mm_srai_epi32(a.v, b); }
+inline int32_4& operator+=(int32_4& a, int32_4 b) { return a = a + b; }
+inline int32_4& operator-=(int32_4& a, int32_4 b) { return a = a - b; }
+
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return (mask & a) | _mm_andnot_ps(mask.v, b.v); }
+inline int32_4 ifelse(int32_4 mask, int32_4 a, int32_4 b) { return (mask & a) | _mm_andnot_si128(mask.v, b.v); }
+inline float ifelse(bool mask, float a, float b) { return mask ? a : b; }
+inline int movemask(float_4 a) { return _mm_movemask_ps(a.v); }
+inline int movemask(int32_4 a) { return _mm_movemask_ps(_mm_castsi128_ps(a.v)); }
+
+inline float_4 fmin(float_4 a, float_4 b) { return _mm_min_ps(a.v, b.v); }
+inline float_4 fmax(float_4 a, float_4 b) { return _mm_max_ps(a.v, b.v); }
+inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) { return fmin(fmax(x, a), b); }
+inline float_4 abs(float_4 a) { return a & float_4::cast(int32_4(0x7fffffff)); }
+inline float_4 floor(float_4 a) { return _mm_floor_ps(a.v); }
+inline float_4 ceil(float_4 a) { return _mm_ceil_ps(a.v); }
+inline float_4 round(float_4 a) { return _mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline float_4 trunc(float_4 a) { return _mm_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+inline float_4 sqrt(float_4 a) { return _mm_sqrt_ps(a.v); }
+
+// Rack uses the sse_mathfun routines for these
+inline float_4 exp(float_4 x) {
+    x = clamp(x, -88.3762626647949f, 88.3762626647949f);
+    float_4 fx = floor(x * 1.44269504088896341f + 0.5f);
+    x = x - fx * 0.693359375f - fx * -2.12194440e-4f;
+    float_4 z = x * x;
+    float_4 y = 1.9875691500E-4f;
+    y = y * x + 1.3981999507E-3f;
+    y = y * x + 8.3334519073E-3f;
+    y = y * x + 4.1665795894E-2f;
+    y = y * x + 1.6666665459E-1f;
+    y = y * x + 5.0000001201E-1f;
+    y = y * z + x + 1.f;
+    return y * float_4::cast((int32_4(fx) + int32_4(127)) << 23);
+}
+
+inline float_4 sin(float_4 x) {
+    float_4 sign = x & float_4(-0.f);
+    x = abs(x);
+    int32_4 j = int32_4(x * 1.27323954473516f);
+    j = (j + int32_4(1)) & int32_4(~1);
+    float_4 y = float_4(j);
+    sign = sign ^ float_4::cast((j & int32_4(4)) << 29);
+    float_4 polyMask = float_4::cast((j & int32_4(2)) == int32_4(0));
+    x = ((x + y * -0.78515625f) + y * -2.4187564849853515625e-4f) + y * -3.77489497744594108e-8f;
+    float_4 z = x * x;
+    float_4 yc = ((2.443315711809948E-005f * z - 1.388731625493765E-003f) * z + 4.166664568298827E-002f) * z * z - z * 0.5f + 1.f;
+    float_4 ys = ((-1.9515295891E-4f * z + 8.3321608736E-3f) * z - 1.6666654611E-1f) * z * x + x;
+    return ifelse(polyMask, ys, yc) ^ sign;
+}
+
+inline float_4 cos(float_4 x) { return sin(x + float(M_PI / 2)); }
+inline float_4 log(float_4 x) { return float_4(std::log(x[0]), std::log(x[1]), std::log(x[2]), std::log(x[3])); }
+inline float_4 pow(float a, float_4 b) { return exp(b * std::log(a)); }
+inline float_4 pow(float_4 a, float_4 b) { return exp(b * log(a)); }
+
+inline float fmin(float a, float b) { return std::fmin(a, b); }
+inline float fmax(float a, float b) { return std::fmax(a, b); }
+inline float clamp(float x, float a = 0.f, float b = 1.f) { return std::fmin(std::fmax(x, a), b); }
+using std::floor;
+using std::ceil;
+using std::round;
+using std::trunc;
+using std::sqrt;
+using std::abs;
+using std::exp;
+using std::sin;
+using std::cos;
+using std::log;
+using std::pow;
+
+} // namespace simd
+
+namespace dsp {
+static const float FREQ_C4 = 261.6256f;
+
+struct ClockDivider {
+    uint32_t clock = 0;
+    uint32_t division = 1;
+    void reset() { clock = 0; }
+    void setDivision(uint32_t division) { this->division = division; }
+    uint32_t getDivision() { return division; }
+    uint32_t getClock() { return clock; }
+    bool process() {
+        clock++;
+        if (clock >= division) {
+            clock = 0;
+            return true;
+        }
+        return false;
+    }
+};
+} // namespace dsp
+
+namespace engine {
+static const int PORT_MAX_CHANNELS = 16;
+
+struct Param {
+    float value = 0.f;
+    float getValue() { return value; }
+    void setValue(float value) { this->value = value; }
+};
+
+struct ParamQuantity {
+    bool snapEnabled = false;
+};
+
+// Inputs are "connected" when channels > 0. The benchmark sets channels directly,
+// the way a cable would.
+struct Port {
+    float voltages[PORT_MAX_CHANNELS] = {};
+    uint8_t channels = 0;
+
+    float getVoltage(int channel = 0) { return voltages[channel]; }
+    void setVoltage(float voltage, int channel = 0) { voltages[channel] = voltage; }
+    float getPolyVoltage(int channel) { return isMonophonic() ? getVoltage(0) : getVoltage(channel); }
+    float getNormalVoltage(float normalVoltage, int channel = 0) { return isConnected() ? getVoltage(channel) : normalVoltage; }
+    template <typename T>
+    T getVoltageSimd(int firstChannel) { return T::load(&voltages[firstChannel]); }
+    template <typename T>
+    T getPolyVoltageSimd(int firstChannel) { return isMonophonic() ? T(getVoltage(0)) : getVoltageSimd<T>(firstChannel); }
+    template <typename T>
+    void setVoltageSimd(T voltage, int firstChannel) { voltage.store(&voltages[firstChannel]); }
+    void setChannels(int channels) {
+        // Like Rack, an unconnected port stays at 0 channels
+        if (this->channels == 0)
+            return;
+        this->channels = channels;
+    }
+    int getChannels() { return channels; }
+    bool isConnected() { return channels > 0; }
+    bool isMonophonic() { return channels == 1; }
+    bool isPolyphonic() { return channels > 1; }
+};
+
+struct Input : Port {};
+struct Output : Port {};
+struct Light {
+    float value = 0.f;
+    void setBrightness(float brightness) { value = brightness; }
+};
+
+struct Module {
+    std::vector<Param> params;
+    std::vector<Input> inputs;
+    std::vector<Output> outputs;
+    std::vector<Light> lights;
+    std::vector<ParamQuantity> paramQuantities;
+
+    struct ProcessArgs {
+        float sampleRate;
+        float sampleTime;
+        int64_t frame;
+    };
+
+    virtual ~Module() {}
+    void config(int numParams, int numInputs, int numOutputs, int numLights) {
+        params.resize(numParams);
+        paramQuantities.resize(numParams);
+        inputs.resize(numInputs);
+        outputs.resize(numOutputs);
+        lights.resize(numLights);
+    }
+    ParamQuantity* configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "",
+        std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+        params[paramId].value = defaultValue;
+        return &paramQuantities[paramId];
+    }
+    void configInput(int portId, std::string name = "") {}
+    void configOutput(int portId, std::string name = "") {}
+
+    virtual void process(const ProcessArgs& args) {}
+    virtual json_t* dataToJson() { return nullptr; }
+    virtual void dataFromJson(json_t* rootJ) {}
+};
+
+struct Engine {
+    float sampleRate = 44100.f;
+    float getSampleRate() { return sampleRate; }
+};
+} // namespace engine
+using namespace engine;
+
+namespace window {
+struct Font {
+    int handle = -1;
+};
+struct Window {
+    std::shared_ptr<Font> uiFont;
+};
+} // namespace window
+
+struct Context {
+    window::Window* window;
+    engine::Engine* engine;
+};
+Context* contextGet();
+#define APP rack::contextGet()
+
+namespace widget {
+struct Widget {
+    math::Rect box;
+    Widget* parent = nullptr;
+    std::vector<Widget*> children;
+
+    struct DrawArgs {
+        NVGcontext* vg;
+        math::Rect clipBox;
+    };
+
+    virtual ~Widget() {}
+    void addChild(Widget* child) {
+        children.push_back(child);
+        child->parent = this;
+    }
+    virtual void draw(const DrawArgs& args) {}
+    virtual void drawLayer(const DrawArgs& args, int layer) {}
+    virtual void step() {}
+};
+struct TransparentWidget : Widget {};
+struct OpaqueWidget : Widget {};
+} // namespace widget
+using namespace widget;
+
+namespace ui {
+struct MenuEntry : Widget {};
+struct MenuItem : MenuEntry {};
+struct MenuSeparator : MenuEntry {};
+struct MenuLabel : MenuEntry {
+    std::string text;
+};
+struct Menu : Widget {};
+} // namespace ui
+using namespace ui;
+
+namespace plugin {
+struct Model {
+    std::string slug;
+};
+struct Plugin {
+    std::string slug;
+    void addModel(Model* model) {}
+};
+} // namespace plugin
+using namespace plugin;
+
+struct Exception : std::runtime_error {
+    explicit Exception(const std::string& message) : std::runtime_error(message) {}
+};
+
+namespace asset {
+std::string plugin(plugin::Plugin* plugin, std::string filename);
+// Under BENCH_USER_DIR, so the benchmark never touches a real Rack user folder
+std::string user(std::string filename);
+} // namespace asset
+
+namespace system {
+void setThreadName(const std::string& name);
+std::string join(const std::string& path1, const std::string& path2);
+bool createDirectories(const std::string& path);
+std::vector<uint8_t> readFile(const std::string& path);
+void writeFile(const std::string& path, const std::vector<uint8_t>& data);
+bool rename(const std::string& srcPath, const std::string& destPath);
+bool remove(const std::string& path);
+std::string getFilename(const std::string& path);
+std::vector<std::string> getEntries(const std::string& dirPath);
+uint64_t getFileSize(const std::string& path);
+} // namespace system
+
+namespace string {
+std::string f(const char* format, ...);
+} // namespace string
+
+namespace app {
+static const float RACK_GRID_WIDTH = 15;
+static const float RACK_GRID_HEIGHT = 380;
+
+struct SvgPanel : Widget {};
+struct ParamWidget : OpaqueWidget {};
+struct PortWidget : OpaqueWidget {};
+
+struct ModuleWidget : OpaqueWidget {
+    Module* module = nullptr;
+    void setModule(Module* module) { this->module = module; }
+    template <class TModule>
+    TModule* getModule() { return dynamic_cast<TModule*>(module); }
+    void setPanel(Widget* panel) { addChild(panel); }
+    void addParam(Widget* param) { addChild(param); }
+    void addInput(Widget* input) { addChild(input); }
+    void addOutput(Widget* output) { addChild(output); }
+    virtual void appendContextMenu(ui::Menu* menu) {}
+};
+} // namespace app
+using namespace app;
+
+namespace componentlibrary {
+struct ScrewSilver : Widget {};
+struct RoundBigBlackKnob : ParamWidget {};
+struct RoundBlackKnob : ParamWidget {};
+struct RoundSmallBlackKnob : ParamWidget {};
+struct Trimpot : ParamWidget {};
+struct PJ301MPort : PortWidget {};
+} // namespace componentlibrary
+using namespace componentlibrary;
+
+app::SvgPanel* createPanel(std::string svgPath);
+
+template <class TWidget>
+TWidget* createWidget(math::Vec pos) {
+    TWidget* widget = new TWidget;
+    widget->box.pos = pos;
+    return widget;
+}
+template <class TParamWidget>
+TParamWidget* createParamCentered(math::Vec pos, engine::Module* module, int paramId) { return createWidget<TParamWidget>(pos); }
+template <class TPortWidget>
+TPortWidget* createInputCentered(math::Vec pos, engine::Module* module, int inputId) { return createWidget<TPortWidget>(pos); }
+template <class TPortWidget>
+TPortWidget* createOutputCentered(math::Vec pos, engine::Module* module, int outputId) { return createWidget<TPortWidget>(pos); }
+template <typename T>
+ui::MenuItem* createBoolPtrMenuItem(std::string text, std::string rightText, T* ptr) { return new ui::MenuItem; }
+ui::MenuItem* createIndexSubmenuItem(std::string text, std::vector<std::string> labels, std::function<size_t()> getter,
+    std::function<void(size_t)> setter, bool disabled = false, bool alwaysConsume = false);
+ui::MenuItem* createMenuItem(std::string text, std::string rightText, std::function<void()> action, bool disabled = false,
+    bool alwaysConsume = false);
+template <class TMenuLabel = ui::MenuLabel>
+TMenuLabel* createMenuLabel(std::string text) {
+    TMenuLabel* label = new TMenuLabel;
+    label->text = text;
+    return label;
+}
+template <class TModule, class TModuleWidget>
+plugin::Model* createModel(std::string slug) {
+    plugin::Model* model = new plugin::Model;
+    model->slug = slug;
+    return model;
+}
+
+} // namespace rack
+using namespace rack;
+
+// Plugin entry point, as declared in plugin/callbacks.hpp
+extern "C" void init(rack::plugin::Plugin* plugin);
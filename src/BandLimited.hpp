@@ -0,0 +1,94 @@
+#pragma once
+#include "plugin.hpp"
+
+// PolyBLEP/BLAMP alias suppression, applied one sample late: a discontinuity found
+// while computing sample n also corrects sample n - 1, which is only output now. That
+// way a discontinuity anywhere inside the sample (phase wraps, sync resets, slope
+// changes) is corrected the same way, without predicting it a sample ahead.
+//
+// Masked lanes only: T is float_4, and corrections apply where mask is set.
+template <typename T>
+struct BlepDelay {
+    // Sample n - 1, already including corrections for discontinuities up to sample n
+    T delayed = 0.f;
+    // Correction for sample n from the discontinuities found so far
+    T correction = 0.f;
+
+    // Step of height jump, d samples before sample n (0 <= d < 1)
+    void addStep(T mask, T d, T jump) {
+        T e = 1.f - d;
+        delayed += simd::ifelse(mask, 0.5f * jump * d * d, 0.f);
+        correction += simd::ifelse(mask, -0.5f * jump * e * e, 0.f);
+    }
+
+    // Slope change of slope per sample, d samples before sample n
+    void addRamp(T mask, T d, T slope) {
+        T e = 1.f - d;
+        delayed += simd::ifelse(mask, (1.f / 6.f) * slope * d * d * d, 0.f);
+        correction += simd::ifelse(mask, (1.f / 6.f) * slope * e * e * e, 0.f);
+    }
+
+    // Stores sample n and returns the finished sample n - 1
+    T process(T naive) {
+        T out = delayed;
+        delayed = naive + correction;
+        correction = 0.f;
+        return out;
+    }
+};
+
+// Half-band FIR coefficients (Kaiser windowed sinc), the non-zero taps on one side of
+// the 0.5 center tap, innermost first
+template <int SIDE_TAPS>
+struct HalfBandCoefficients;
+
+// 15 taps: flat to 0.1 of the input rate (0.4 of the output Nyquist), -60 dB stopband.
+// Enough for the first stage of 4x, whose output is filtered again.
+template <>
+struct HalfBandCoefficients<4> {
+    static const float* get() {
+        static const float taps[4] = {3.006523661e-01f, -6.268655536e-02f, 1.271108646e-02f, -6.768971521e-04f};
+        return taps;
+    }
+};
+
+// 31 taps: flat (0.003 dB) to 0.17 of the input rate (0.68 of the output Nyquist), -71 dB stopband
+template <>
+struct HalfBandCoefficients<8> {
+    static const float* get() {
+        static const float taps[8] = {3.137205370e-01f, -9.308770935e-02f, 4.398981936e-02f, -2.159408059e-02f,
+            9.806321382e-03f, -3.774111593e-03f, 1.065386445e-03f, -1.261626359e-04f};
+        return taps;
+    }
+};
+
+// Decimates by 2 with a half-band FIR. Every other tap is zero, so each output costs
+// SIDE_TAPS + 1 multiplies.
+template <typename T, int SIDE_TAPS>
+struct HalfBandDecimator {
+    static const int LENGTH = 4 * SIDE_TAPS - 1;
+    static const int CENTER = 2 * SIDE_TAPS - 1;
+
+    // Every sample is written twice, so the last LENGTH inputs are always contiguous
+    T history[2 * LENGTH] = {};
+    int pos = 0;
+
+    // x0 then x1, in time order
+    T process(T x0, T x1) {
+        push(x0);
+        push(x1);
+        // Oldest first
+        const T* x = &history[pos];
+        const float* taps = HalfBandCoefficients<SIDE_TAPS>::get();
+        T y = 0.5f * x[CENTER];
+        for (int j = 0; j < SIDE_TAPS; j++)
+            y += taps[j] * (x[CENTER - 1 - 2 * j] + x[CENTER + 1 + 2 * j]);
+        return y;
+    }
+
+    void push(T x) {
+        history[pos] = x;
+        history[pos + LENGTH] = x;
+        pos = (pos + 1 == LENGTH) ? 0 : pos + 1;
+    }
+};
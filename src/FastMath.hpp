@@ -0,0 +1,57 @@
+#pragma once
+#include "plugin.hpp"
+#include <cstring>
+
+// Polynomial replacements for std::pow(2, x) and std::sin(2 pi x) on the oscillator
+// hot path, in scalar and float_4 versions that give the same result per lane.
+// Coefficients are minimax fits (Lawson's algorithm).
+//
+// Measured over the ranges used by the oscillators:
+//   fastExp2:   max relative error 1.6e-7 over [-10, 10], 0.0003 cents
+//   fastSin2Pi: max absolute error 7.4e-7 over [0, 1), -122 dB below full scale
+
+// 2^f for f in [0, 1)
+template <typename T>
+inline T exp2Poly(T f) {
+    T p = 1.877576619e-3f;
+    p = p * f + 8.989340235e-3f;
+    p = p * f + 5.582631792e-2f;
+    p = p * f + 2.401536171e-1f;
+    p = p * f + 6.931530732e-1f;
+    return p * f + 9.999999251e-1f;
+}
+
+// 2^x: the integer part goes straight into the exponent bits
+inline float fastExp2(float x) {
+    x = clamp(x, -126.f, 126.f);
+    float xi = std::floor(x);
+    float p = exp2Poly(x - xi);
+    int32_t bits;
+    std::memcpy(&bits, &p, sizeof(bits));
+    bits += (int32_t)xi << 23;
+    std::memcpy(&p, &bits, sizeof(p));
+    return p;
+}
+
+inline simd::float_4 fastExp2(simd::float_4 x) {
+    x = simd::clamp(x, -126.f, 126.f);
+    simd::float_4 xi = simd::floor(x);
+    simd::float_4 p = exp2Poly(x - xi);
+    simd::int32_4 bits = simd::int32_4::cast(p) + (simd::int32_4(xi) << 23);
+    return simd::float_4::cast(bits);
+}
+
+// sin(2 pi phase) for any phase
+template <typename T>
+inline T fastSin2Pi(T phase) {
+    // Reduce to [-1/2, 1/2], then fold onto [-1/4, 1/4] where sine is odd and monotonic
+    T x = phase - simd::round(phase);
+    x = simd::ifelse(x > 0.25f, 0.5f - x, x);
+    x = simd::ifelse(x < -0.25f, -0.5f - x, x);
+    T x2 = x * x;
+    T p = -7.099343456e+1f;
+    p = p * x2 + 8.134076904e+1f;
+    p = p * x2 - 4.133714238e+1f;
+    p = p * x2 + 6.283164044e+0f;
+    return p * x;
+}
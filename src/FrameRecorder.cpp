@@ -0,0 +1,150 @@
+#include "FrameRecorder.hpp"
+#include <cstring>
+
+bool FrameRecorder::start(const std::string& directory, FrameFormat format, int maxWidth, int maxHeight, std::string& error) {
+    stop();
+    system::createDirectories(directory);
+    std::string indexPath = system::join(directory, "index.csv");
+    index = std::fopen(indexPath.c_str(), "w");
+    if (!index) {
+        error = "Cannot create " + indexPath;
+        return false;
+    }
+    std::fprintf(index, "frame,time,width,height,file\n");
+
+    this->directory = directory;
+    this->format = format;
+    maxPixels = maxWidth * maxHeight;
+    slots.resize(POOL_FRAMES);
+    for (int i = 0; i < POOL_FRAMES; i++) {
+        slots[i].pixels.assign(maxPixels * 4, 0);
+        freeSlots[i] = i;
+    }
+    row.assign(maxWidth * 3, 0);
+    freeCount = POOL_FRAMES;
+    queuedHead = 0;
+    queuedCount = 0;
+    quit = false;
+    skipped.clear();
+    written.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+    bytes.store(0, std::memory_order_relaxed);
+    failed.store(false, std::memory_order_relaxed);
+
+    writer = std::thread([this]() { writerLoop(); });
+    return true;
+}
+
+void FrameRecorder::stop() {
+    if (!writer.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    queuedCv.notify_one();
+    writer.join();
+
+    for (const std::pair<uint32_t, double>& frame : skipped)
+        std::fprintf(index, "%u,%.6f,0,0,\n", frame.first, frame.second);
+    std::vector<std::pair<uint32_t, double>>().swap(skipped);
+    std::fclose(index);
+    index = nullptr;
+    // The pool is about 4 MB at the largest frame size, so it only exists while recording
+    std::vector<Slot>().swap(slots);
+    std::vector<uint8_t>().swap(row);
+}
+
+bool FrameRecorder::submit(const uint8_t* pixels, int width, int height, uint32_t number, double time, bool wait) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (wait)
+        freeCv.wait(lock, [this]() { return freeCount > 0; });
+    if (freeCount == 0 || width * height > maxPixels) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    int index = freeSlots[--freeCount];
+    lock.unlock();
+
+    // The slot is ours until it is queued, so the copy runs without the lock
+    Slot& slot = slots[index];
+    std::memcpy(slot.pixels.data(), pixels, width * height * 4);
+    slot.width = width;
+    slot.height = height;
+    slot.number = number;
+    slot.time = time;
+
+    lock.lock();
+    queued[(queuedHead + queuedCount) % POOL_FRAMES] = index;
+    queuedCount++;
+    lock.unlock();
+    queuedCv.notify_one();
+    return true;
+}
+
+void FrameRecorder::skip(uint32_t number, double time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    skipped.push_back(std::make_pair(number, time));
+}
+
+void FrameRecorder::writerLoop() {
+    system::setThreadName("JuliaScope recorder");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        queuedCv.wait(lock, [this]() { return quit || queuedCount > 0; });
+        // Quit only once everything queued is on disk
+        if (queuedCount == 0)
+            return;
+        int index = queued[queuedHead];
+        queuedHead = (queuedHead + 1) % POOL_FRAMES;
+        queuedCount--;
+
+        lock.unlock();
+        // After a failed write the rest of the frames are only returned to the pool, so a
+        // waiting producer never blocks for good
+        if (!failed.load(std::memory_order_relaxed) && !writeFrame(slots[index]))
+            failed.store(true, std::memory_order_relaxed);
+        lock.lock();
+
+        freeSlots[freeCount++] = index;
+        freeCv.notify_one();
+    }
+}
+
+bool FrameRecorder::writeFrame(const Slot& slot) {
+    std::string name = string::f("frame_%06u.%s", slot.number, format == FRAME_FORMAT_PPM ? "ppm" : "rgba");
+    std::FILE* f = std::fopen(system::join(directory, name).c_str(), "wb");
+    if (!f)
+        return false;
+
+    bool ok = true;
+    size_t size = 0;
+    if (format == FRAME_FORMAT_PPM) {
+        int header = std::fprintf(f, "P6\n%d %d\n255\n", slot.width, slot.height);
+        ok = header > 0;
+        size = header;
+        for (int y = 0; y < slot.height && ok; y++) {
+            const uint8_t* in = &slot.pixels[y * slot.width * 4];
+            for (int x = 0; x < slot.width; x++) {
+                row[x * 3 + 0] = in[x * 4 + 0];
+                row[x * 3 + 1] = in[x * 4 + 1];
+                row[x * 3 + 2] = in[x * 4 + 2];
+            }
+            ok = std::fwrite(row.data(), 3, slot.width, f) == (size_t)slot.width;
+            size += slot.width * 3;
+        }
+    } else {
+        size = slot.width * slot.height * 4;
+        ok = std::fwrite(slot.pixels.data(), 1, size, f) == size;
+    }
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok)
+        return false;
+
+    // Flushed per frame, so the index matches the files even if Rack quits mid-recording
+    std::fprintf(index, "%u,%.6f,%d,%d,%s\n", slot.number, slot.time, slot.width, slot.height, name.c_str());
+    std::fflush(index);
+    written.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "plugin.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+enum FrameFormat {
+    // Binary P6 files, RGB with the alpha dropped, which ffmpeg and most image tools read
+    FRAME_FORMAT_PPM,
+    // The RGBA bytes as rendered, with the size in the index
+    FRAME_FORMAT_RAW,
+    FRAME_FORMATS_LEN
+};
+
+// Streams RGBA frames to numbered files in a directory on a background thread, and lists
+// each one with its number, time and size in index.csv. Frames are copied into a pool
+// of POOL_FRAMES buffers allocated by start(), so a recording allocates nothing per
+// frame. A producer that gets ahead of the disk either waits for a buffer or drops the
+// frame, whichever it asks for.
+struct FrameRecorder {
+    static const int POOL_FRAMES = 8;
+
+    ~FrameRecorder() { stop(); }
+
+    // UI thread: start a recording in directory, created if needed, of frames up to
+    // maxWidth x maxHeight. Returns false, with error set, if the index can't be created.
+    bool start(const std::string& directory, FrameFormat format, int maxWidth, int maxHeight, std::string& error);
+    // UI thread: write out the frames still queued, close the index and free the pool
+    void stop();
+    bool isRecording() const { return writer.joinable(); }
+
+    // Producer thread, one at a time: copy a frame into the pool and queue it for writing.
+    // With every buffer still queued, this waits for one if wait is set, and otherwise
+    // drops the frame and returns false.
+    bool submit(const uint8_t* pixels, int width, int height, uint32_t number, double time, bool wait);
+    // Producer thread, one at a time: list a frame that won't be submitted, with a size of
+    // 0 and no file. Skipped frames go at the end of the index when the recording stops.
+    void skip(uint32_t number, double time);
+
+    // Any thread: frames written and dropped in this recording, and whether a write failed
+    uint32_t getWritten() const { return written.load(std::memory_order_relaxed); }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    uint64_t getBytes() const { return bytes.load(std::memory_order_relaxed); }
+    bool hasFailed() const { return failed.load(std::memory_order_relaxed); }
+    // UI thread
+    const std::string& getDirectory() const { return directory; }
+
+private:
+    struct Slot {
+        std::vector<uint8_t> pixels;
+        int width = 0;
+        int height = 0;
+        uint32_t number = 0;
+        double time = 0.0;
+    };
+
+    void writerLoop();
+    bool writeFrame(const Slot& slot);
+
+    std::string directory;
+    FrameFormat format = FRAME_FORMAT_PPM;
+    int maxPixels = 0;
+    std::FILE* index = nullptr;
+    std::vector<Slot> slots;
+    // Writer only: one RGB row for PPM output
+    std::vector<uint8_t> row;
+
+    std::thread writer;
+    std::mutex mutex;
+    // Signals the writer: a frame is queued, or quit
+    std::condition_variable queuedCv;
+    // Signals a waiting producer: a buffer is free
+    std::condition_variable freeCv;
+    // Slot indices, under mutex: a stack of free ones, and a ring of queued ones in submission order
+    int freeSlots[POOL_FRAMES];
+    int freeCount = 0;
+    int queued[POOL_FRAMES];
+    int queuedHead = 0;
+    int queuedCount = 0;
+    bool quit = false;
+    // Number and time of each skipped frame, under mutex
+    std::vector<std::pair<uint32_t, double>> skipped;
+
+    std::atomic<uint32_t> written{0};
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<bool> failed{false};
+};
@@ -0,0 +1,504 @@
+#include "JuliaRender.hpp"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define JULIA_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+// All kernels evaluate exactly the same float expressions in the same order as the
+// scalar loop, so every ISA produces bit-identical iteration counts.
+//
+// Periodicity detection: every orbit point is compared with a saved reference point,
+// which is refreshed at iterations 8, 16, 32, ... (Brent's cycle detection). An orbit
+// that comes back within PERIOD_EPSILON of it has been caught by an attracting cycle,
+// so the pixel is interior and would run all the way to maxIter.
+static const float PERIOD_EPSILON = 1e-5f;
+static const int FIRST_PERIOD_CHECKPOINT = 8;
+
+// Perturbation: a point z = Z + d near a reference point Z maps to
+// (Z + d)^2 + c = (Z^2 + c) + (2Z + d) d, so the offset follows d' = (2Z + d) d, which
+// doesn't involve c and keeps its full relative precision however small d is. Once
+// |Z + d| < |d|, d has become the larger, imprecise term; the point is then rebased onto
+// the critical orbit, which starts at 0, so its offset from there is just z.
+// Periodicity uses the reference's tolerance instead of PERIOD_EPSILON.
+
+template <bool PERIODICITY>
+static uint64_t escapeScalarImpl(const float* x0, const float* y0, int count, float cReal, float cImag, int maxIter, int32_t* iters) {
+    uint64_t work = 0;
+    for (int i = 0; i < count; i++) {
+        float x = x0[i];
+        float y = y0[i];
+        int iter = 0;
+        float refX = x;
+        float refY = y;
+        int checkpoint = FIRST_PERIOD_CHECKPOINT;
+        bool periodic = false;
+
+        while (x * x + y * y <= 4.f && iter < maxIter) {
+            float xTemp = x * x - y * y + cReal;
+            y = 2.f * x * y + cImag;
+            x = xTemp;
+            iter++;
+
+            if (PERIODICITY) {
+                if (std::fabs(x - refX) < PERIOD_EPSILON && std::fabs(y - refY) < PERIOD_EPSILON) {
+                    periodic = true;
+                    break;
+                }
+                if (iter == checkpoint) {
+                    refX = x;
+                    refY = y;
+                    checkpoint *= 2;
+                }
+            }
+        }
+        work += iter;
+        iters[i] = periodic ? maxIter : iter;
+    }
+    return work;
+}
+
+uint64_t escapeScalar(const float* x0, const float* y0, int count, float cReal, float cImag, int maxIter, bool periodicity, int32_t* iters) {
+    if (periodicity)
+        return escapeScalarImpl<true>(x0, y0, count, cReal, cImag, maxIter, iters);
+    return escapeScalarImpl<false>(x0, y0, count, cReal, cImag, maxIter, iters);
+}
+
+template <bool PERIODICITY>
+static uint64_t perturbScalarImpl(const float* dx0, const float* dy0, int count, const JuliaReference& reference, int maxIter, int32_t* iters) {
+    const float* refX = reference.x.data();
+    const float* refY = reference.y.data();
+    uint64_t work = 0;
+    for (int i = 0; i < count; i++) {
+        float dx = dx0[i];
+        float dy = dy0[i];
+        int m = 0;
+        int last = reference.centerLast;
+        float x = refX[0] + dx;
+        float y = refY[0] + dy;
+        int iter = 0;
+        // Saved point as reference point and offset
+        float periodRefX = refX[0];
+        float periodRefY = refY[0];
+        float periodDx = dx;
+        float periodDy = dy;
+        int checkpoint = FIRST_PERIOD_CHECKPOINT;
+        bool periodic = false;
+
+        while (x * x + y * y <= 4.f && iter < maxIter) {
+            if (x * x + y * y < dx * dx + dy * dy || m == last) {
+                dx = x;
+                dy = y;
+                m = reference.criticalFirst;
+                last = reference.criticalLast;
+            }
+            float tx = 2.f * refX[m] + dx;
+            float ty = 2.f * refY[m] + dy;
+            float dxTemp = tx * dx - ty * dy;
+            dy = tx * dy + ty * dx;
+            dx = dxTemp;
+            m++;
+            x = refX[m] + dx;
+            y = refY[m] + dy;
+            iter++;
+
+            if (PERIODICITY) {
+                // Reference points and offsets apart, since x and y round away differences
+                // much smaller than themselves. Both parts settle once the orbit has.
+                float epsilon = reference.periodEpsilon;
+                if (std::fabs(refX[m] - periodRefX) < epsilon && std::fabs(refY[m] - periodRefY) < epsilon
+                    && std::fabs(dx - periodDx) < epsilon && std::fabs(dy - periodDy) < epsilon) {
+                    periodic = true;
+                    break;
+                }
+                if (iter == checkpoint) {
+                    periodRefX = refX[m];
+                    periodRefY = refY[m];
+                    periodDx = dx;
+                    periodDy = dy;
+                    checkpoint *= 2;
+                }
+            }
+        }
+        work += iter;
+        iters[i] = periodic ? maxIter : iter;
+    }
+    return work;
+}
+
+uint64_t perturbScalar(const float* dx0, const float* dy0, int count, const JuliaReference& reference, int maxIter, bool periodicity, int32_t* iters) {
+    if (periodicity)
+        return perturbScalarImpl<true>(dx0, dy0, count, reference, maxIter, iters);
+    return perturbScalarImpl<false>(dx0, dy0, count, reference, maxIter, iters);
+}
+
+#ifdef JULIA_KERNEL_X86
+
+static inline uint64_t sumLanes(__m128i v) {
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, v);
+    return (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// 4 pixels per lane group. Lanes that escape drop out of the active mask and stop
+// counting; the group exits once every lane has escaped.
+template <bool PERIODICITY>
+static uint64_t escapeSse2Impl(const float* x0, const float* y0, int count, float cReal, float cImag, int maxIter, int32_t* iters) {
+    const __m128 four = _mm_set1_ps(4.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 cr = _mm_set1_ps(cReal);
+    const __m128 ci = _mm_set1_ps(cImag);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 epsilon = _mm_set1_ps(PERIOD_EPSILON);
+    const __m128i maxIterV = _mm_set1_epi32(maxIter);
+
+    uint64_t work = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(x0 + i);
+        __m128 y = _mm_loadu_ps(y0 + i);
+        __m128 active = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        __m128i iter = _mm_setzero_si128();
+        // Iterations skipped by lanes that were found to be periodic
+        __m128i skipped = _mm_setzero_si128();
+        __m128 refX = x;
+        __m128 refY = y;
+        int checkpoint = FIRST_PERIOD_CHECKPOINT;
+
+        for (int n = 0; n < maxIter; n++) {
+            __m128 x2 = _mm_mul_ps(x, x);
+            __m128 y2 = _mm_mul_ps(y, y);
+            active = _mm_and_ps(active, _mm_cmple_ps(_mm_add_ps(x2, y2), four));
+            if (_mm_movemask_ps(active) == 0)
+                break;
+            // Active lanes are all ones (-1), so subtracting the mask counts them
+            iter = _mm_sub_epi32(iter, _mm_castps_si128(active));
+
+            __m128 xTemp = _mm_add_ps(_mm_sub_ps(x2, y2), cr);
+            y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(two, x), y), ci);
+            x = xTemp;
+
+            if (PERIODICITY) {
+                // Every active lane has counted n + 1 iterations, so one checkpoint schedule serves them all
+                __m128 nearX = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(x, refX), absMask), epsilon);
+                __m128 nearY = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(y, refY), absMask), epsilon);
+                __m128 periodic = _mm_and_ps(active, _mm_and_ps(nearX, nearY));
+                if (_mm_movemask_ps(periodic)) {
+                    __m128i periodicI = _mm_castps_si128(periodic);
+                    skipped = _mm_add_epi32(skipped, _mm_and_si128(periodicI, _mm_sub_epi32(maxIterV, iter)));
+                    iter = _mm_or_si128(_mm_andnot_si128(periodicI, iter), _mm_and_si128(periodicI, maxIterV));
+                    active = _mm_andnot_ps(periodic, active);
+                }
+                if (n + 1 == checkpoint) {
+                    refX = x;
+                    refY = y;
+                    checkpoint *= 2;
+                }
+            }
+        }
+
+        _mm_storeu_si128((__m128i*)(iters + i), iter);
+        work += sumLanes(iter) - sumLanes(skipped);
+    }
+
+    return work + escapeScalarImpl<PERIODICITY>(x0 + i, y0 + i, count - i, cReal, cImag, maxIter, iters + i);
+}
+
+static uint64_t escapeSse2(const float* x0, const float* y0, int count, float cReal, float cImag, int maxIter, bool periodicity, int32_t* iters) {
+    if (periodicity)
+        return escapeSse2Impl<true>(x0, y0, count, cReal, cImag, maxIter, iters);
+    return escapeSse2Impl<false>(x0, y0, count, cReal, cImag, maxIter, iters);
+}
+
+static inline __m128 gatherSse2(const float* base, __m128i index) {
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, index);
+    return _mm_setr_ps(base[lanes[0]], base[lanes[1]], base[lanes[2]], base[lanes[3]]);
+}
+
+static inline __m128 selectSse2(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Each lane follows its own reference index, so the orbit points are gathered
+template <bool PERIODICITY>
+static uint64_t perturbSse2Impl(const float* dx0, const float* dy0, int count, const JuliaReference& reference, int maxIter, int32_t* iters) {
+    const float* refX = reference.x.data();
+    const float* refY = reference.y.data();
+    const __m128 four = _mm_set1_ps(4.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 epsilon = _mm_set1_ps(reference.periodEpsilon);
+    const __m128i maxIterV = _mm_set1_epi32(maxIter);
+    const __m128i criticalFirst = _mm_set1_epi32(reference.criticalFirst);
+    const __m128i criticalLast = _mm_set1_epi32(reference.criticalLast);
+
+    uint64_t work = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_loadu_ps(dx0 + i);
+        __m128 dy = _mm_loadu_ps(dy0 + i);
+        __m128i m = _mm_setzero_si128();
+        __m128i last = _mm_set1_epi32(reference.centerLast);
+        __m128 x = _mm_add_ps(_mm_set1_ps(refX[0]), dx);
+        __m128 y = _mm_add_ps(_mm_set1_ps(refY[0]), dy);
+        __m128 active = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        __m128i iter = _mm_setzero_si128();
+        __m128i skipped = _mm_setzero_si128();
+        __m128 periodRefX = _mm_set1_ps(refX[0]);
+        __m128 periodRefY = _mm_set1_ps(refY[0]);
+        __m128 periodDx = dx;
+        __m128 periodDy = dy;
+        int checkpoint = FIRST_PERIOD_CHECKPOINT;
+
+        for (int n = 0; n < maxIter; n++) {
+            __m128 r2 = _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+            active = _mm_and_ps(active, _mm_cmple_ps(r2, four));
+            if (_mm_movemask_ps(active) == 0)
+                break;
+            iter = _mm_sub_epi32(iter, _mm_castps_si128(active));
+
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            __m128 rebase = _mm_or_ps(_mm_cmplt_ps(r2, d2), _mm_castsi128_ps(_mm_cmpeq_epi32(m, last)));
+            dx = selectSse2(rebase, x, dx);
+            dy = selectSse2(rebase, y, dy);
+            __m128i rebaseI = _mm_castps_si128(rebase);
+            m = _mm_or_si128(_mm_and_si128(rebaseI, criticalFirst), _mm_andnot_si128(rebaseI, m));
+            last = _mm_or_si128(_mm_and_si128(rebaseI, criticalLast), _mm_andnot_si128(rebaseI, last));
+
+            __m128 tx = _mm_add_ps(_mm_mul_ps(two, gatherSse2(refX, m)), dx);
+            __m128 ty = _mm_add_ps(_mm_mul_ps(two, gatherSse2(refY, m)), dy);
+            __m128 dxTemp = _mm_sub_ps(_mm_mul_ps(tx, dx), _mm_mul_ps(ty, dy));
+            dy = _mm_add_ps(_mm_mul_ps(tx, dy), _mm_mul_ps(ty, dx));
+            dx = dxTemp;
+            // Escaped lanes keep their index, so it never runs past the end of their orbit
+            m = _mm_sub_epi32(m, _mm_castps_si128(active));
+            __m128 refXm = gatherSse2(refX, m);
+            __m128 refYm = gatherSse2(refY, m);
+            x = _mm_add_ps(refXm, dx);
+            y = _mm_add_ps(refYm, dy);
+
+            if (PERIODICITY) {
+                __m128 nearRefX = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(refXm, periodRefX), absMask), epsilon);
+                __m128 nearRefY = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(refYm, periodRefY), absMask), epsilon);
+                __m128 nearDx = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(dx, periodDx), absMask), epsilon);
+                __m128 nearDy = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(dy, periodDy), absMask), epsilon);
+                __m128 near = _mm_and_ps(_mm_and_ps(nearRefX, nearRefY), _mm_and_ps(nearDx, nearDy));
+                __m128 periodic = _mm_and_ps(active, near);
+                if (_mm_movemask_ps(periodic)) {
+                    __m128i periodicI = _mm_castps_si128(periodic);
+                    skipped = _mm_add_epi32(skipped, _mm_and_si128(periodicI, _mm_sub_epi32(maxIterV, iter)));
+                    iter = _mm_or_si128(_mm_andnot_si128(periodicI, iter), _mm_and_si128(periodicI, maxIterV));
+                    active = _mm_andnot_ps(periodic, active);
+                }
+                if (n + 1 == checkpoint) {
+                    periodRefX = refXm;
+                    periodRefY = refYm;
+                    periodDx = dx;
+                    periodDy = dy;
+                    checkpoint *= 2;
+                }
+            }
+        }
+
+        _mm_storeu_si128((__m128i*)(iters + i), iter);
+        work += sumLanes(iter) - sumLanes(skipped);
+    }
+
+    return work + perturbScalarImpl<PERIODICITY>(dx0 + i, dy0 + i, count - i, reference, maxIter, iters + i);
+}
+
+static uint64_t perturbSse2(const float* dx0, const float* dy0, int count, const JuliaReference& reference, int maxIter, bool periodicity, int32_t* iters) {
+    if (periodicity)
+        return perturbSse2Impl<true>(dx0, dy0, count, reference, maxIter, iters);
+    return perturbSse2Impl<false>(dx0, dy0, count, reference, maxIter, iters);
+}
+
+// Same as the SSE2 kernel with 8 lanes. Only "avx2" is enabled, not "fma", so the
+// compiler cannot contract the multiply-adds and change the rounding.
+template <bool PERIODICITY>
+__attribute__((target("avx2")))
+static uint64_t escapeAvx2Impl(const float* x0, const float* y0, int count, float cReal, float cImag, int maxIter, int32_t* iters) {
+    const __m256 four = _mm256_set1_ps(4.f);
+    const __m256 two = _mm256_set1_ps(2.f);
+    const __m256 cr = _mm256_set1_ps(cReal);
+    const __m256 ci = _mm256_set1_ps(cImag);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 epsilon = _mm256_set1_ps(PERIOD_EPSILON);
+    const __m256i maxIterV = _mm256_set1_epi32(maxIter);
+
+    uint64_t work = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(x0 + i);
+        __m256 y = _mm256_loadu_ps(y0 + i);
+        __m256 active = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        __m256i iter = _mm256_setzero_si256();
+        __m256i skipped = _mm256_setzero_si256();
+        __m256 refX = x;
+        __m256 refY = y;
+        int checkpoint = FIRST_PERIOD_CHECKPOINT;
+
+        for (int n = 0; n < maxIter; n++) {
+            __m256 x2 = _mm256_mul_ps(x, x);
+            __m256 y2 = _mm256_mul_ps(y, y);
+            active = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_add_ps(x2, y2), four, _CMP_LE_OQ));
+            if (_mm256_movemask_ps(active) == 0)
+                break;
+            iter = _mm256_sub_epi32(iter, _mm256_castps_si256(active));
+
+            __m256 xTemp = _mm256_add_ps(_mm256_sub_ps(x2, y2), cr);
+            y = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(two, x), y), ci);
+            x = xTemp;
+
+            if (PERIODICITY) {
+                __m256 nearX = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(x, refX), absMask), epsilon, _CMP_LT_OQ);
+                __m256 nearY = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(y, refY), absMask), epsilon, _CMP_LT_OQ);
+                __m256 periodic = _mm256_and_ps(active, _mm256_and_ps(nearX, nearY));
+                if (_mm256_movemask_ps(periodic)) {
+                    __m256i periodicI = _mm256_castps_si256(periodic);
+                    skipped = _mm256_add_epi32(skipped, _mm256_and_si256(periodicI, _mm256_sub_epi32(maxIterV, iter)));
+                    iter = _mm256_blendv_epi8(iter, maxIterV, periodicI);
+                    active = _mm256_andnot_ps(periodic, active);
+                }
+                if (n + 1 == checkpoint) {
+                    refX = x;
+                    refY = y;
+                    checkpoint *= 2;
+                }
+            }
+        }
+
+        _mm256_storeu_si256((__m256i*)(iters + i), iter);
+        __m256i net = _mm256_sub_epi32(iter, skipped);
+        work += sumLanes(_mm_add_epi32(_mm256_castsi256_si128(net), _mm256_extracti128_si256(net, 1)));
+    }
+
+    return work + escapeSse2Impl<PERIODICITY>(x0 + i, y0 + i, count - i, cReal, cImag, maxIter, iters + i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t escapeAvx2(const float* x0, const float* y0, int count, float cReal, float cImag, int maxIter, bool periodicity, int32_t* iters) {
+    if (periodicity)
+        return escapeAvx2Impl<true>(x0, y0, count, cReal, cImag, maxIter, iters);
+    return escapeAvx2Impl<false>(x0, y0, count, cReal, cImag, maxIter, iters);
+}
+
+template <bool PERIODICITY>
+__attribute__((target("avx2")))
+static uint64_t perturbAvx2Impl(const float* dx0, const float* dy0, int count, const JuliaReference& reference, int maxIter, int32_t* iters) {
+    const float* refX = reference.x.data();
+    const float* refY = reference.y.data();
+    const __m256 four = _mm256_set1_ps(4.f);
+    const __m256 two = _mm256_set1_ps(2.f);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 epsilon = _mm256_set1_ps(reference.periodEpsilon);
+    const __m256i maxIterV = _mm256_set1_epi32(maxIter);
+    const __m256i criticalFirst = _mm256_set1_epi32(reference.criticalFirst);
+    const __m256i criticalLast = _mm256_set1_epi32(reference.criticalLast);
+
+    uint64_t work = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_loadu_ps(dx0 + i);
+        __m256 dy = _mm256_loadu_ps(dy0 + i);
+        __m256i m = _mm256_setzero_si256();
+        __m256i last = _mm256_set1_epi32(reference.centerLast);
+        __m256 x = _mm256_add_ps(_mm256_set1_ps(refX[0]), dx);
+        __m256 y = _mm256_add_ps(_mm256_set1_ps(refY[0]), dy);
+        __m256 active = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        __m256i iter = _mm256_setzero_si256();
+        __m256i skipped = _mm256_setzero_si256();
+        __m256 periodRefX = _mm256_set1_ps(refX[0]);
+        __m256 periodRefY = _mm256_set1_ps(refY[0]);
+        __m256 periodDx = dx;
+        __m256 periodDy = dy;
+        int checkpoint = FIRST_PERIOD_CHECKPOINT;
+
+        for (int n = 0; n < maxIter; n++) {
+            __m256 r2 = _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y));
+            active = _mm256_and_ps(active, _mm256_cmp_ps(r2, four, _CMP_LE_OQ));
+            if (_mm256_movemask_ps(active) == 0)
+                break;
+            iter = _mm256_sub_epi32(iter, _mm256_castps_si256(active));
+
+            __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            __m256 rebase = _mm256_or_ps(_mm256_cmp_ps(r2, d2, _CMP_LT_OQ), _mm256_castsi256_ps(_mm256_cmpeq_epi32(m, last)));
+            dx = _mm256_blendv_ps(dx, x, rebase);
+            dy = _mm256_blendv_ps(dy, y, rebase);
+            __m256i rebaseI = _mm256_castps_si256(rebase);
+            m = _mm256_blendv_epi8(m, criticalFirst, rebaseI);
+            last = _mm256_blendv_epi8(last, criticalLast, rebaseI);
+
+            __m256 tx = _mm256_add_ps(_mm256_mul_ps(two, _mm256_i32gather_ps(refX, m, 4)), dx);
+            __m256 ty = _mm256_add_ps(_mm256_mul_ps(two, _mm256_i32gather_ps(refY, m, 4)), dy);
+            __m256 dxTemp = _mm256_sub_ps(_mm256_mul_ps(tx, dx), _mm256_mul_ps(ty, dy));
+            dy = _mm256_add_ps(_mm256_mul_ps(tx, dy), _mm256_mul_ps(ty, dx));
+            dx = dxTemp;
+            m = _mm256_sub_epi32(m, _mm256_castps_si256(active));
+            __m256 refXm = _mm256_i32gather_ps(refX, m, 4);
+            __m256 refYm = _mm256_i32gather_ps(refY, m, 4);
+            x = _mm256_add_ps(refXm, dx);
+            y = _mm256_add_ps(refYm, dy);
+
+            if (PERIODICITY) {
+                __m256 nearRefX = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(refXm, periodRefX), absMask), epsilon, _CMP_LT_OQ);
+                __m256 nearRefY = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(refYm, periodRefY), absMask), epsilon, _CMP_LT_OQ);
+                __m256 nearDx = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(dx, periodDx), absMask), epsilon, _CMP_LT_OQ);
+                __m256 nearDy = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(dy, periodDy), absMask), epsilon, _CMP_LT_OQ);
+                __m256 near = _mm256_and_ps(_mm256_and_ps(nearRefX, nearRefY), _mm256_and_ps(nearDx, nearDy));
+                __m256 periodic = _mm256_and_ps(active, near);
+                if (_mm256_movemask_ps(periodic)) {
+                    __m256i periodicI = _mm256_castps_si256(periodic);
+                    skipped = _mm256_add_epi32(skipped, _mm256_and_si256(periodicI, _mm256_sub_epi32(maxIterV, iter)));
+                    iter = _mm256_blendv_epi8(iter, maxIterV, periodicI);
+                    active = _mm256_andnot_ps(periodic, active);
+                }
+                if (n + 1 == checkpoint) {
+                    periodRefX = refXm;
+                    periodRefY = refYm;
+                    periodDx = dx;
+                    periodDy = dy;
+                    checkpoint *= 2;
+                }
+            }
+        }
+
+        _mm256_storeu_si256((__m256i*)(iters + i), iter);
+        __m256i net = _mm256_sub_epi32(iter, skipped);
+        work += sumLanes(_mm_add_epi32(_mm256_castsi256_si128(net), _mm256_extracti128_si256(net, 1)));
+    }
+
+    return work + perturbSse2Impl<PERIODICITY>(dx0 + i, dy0 + i, count - i, reference, maxIter, iters + i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t perturbAvx2(const float* dx0, const float* dy0, int count, const JuliaReference& reference, int maxIter, bool periodicity, int32_t* iters) {
+    if (periodicity)
+        return perturbAvx2Impl<true>(dx0, dy0, count, reference, maxIter, iters);
+    return perturbAvx2Impl<false>(dx0, dy0, count, reference, maxIter, iters);
+}
+
+#endif
+
+static std::vector<EscapeKernel> detectEscapeKernels() {
+    std::vector<EscapeKernel> kernels;
+#ifdef JULIA_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernels.push_back(EscapeKernel{"AVX2", escapeAvx2, perturbAvx2});
+    kernels.push_back(EscapeKernel{"SSE2", escapeSse2, perturbSse2});
+#endif
+    kernels.push_back(EscapeKernel{"Scalar", escapeScalar, perturbScalar});
+    return kernels;
+}
+
+const std::vector<EscapeKernel>& getSupportedEscapeKernels() {
+    static const std::vector<EscapeKernel> kernels = detectEscapeKernels();
+    return kernels;
+}
+
+const EscapeKernel& getEscapeKernel() {
+    return getSupportedEscapeKernels().front();
+}
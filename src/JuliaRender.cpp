@@ -0,0 +1,1105 @@
+#include "JuliaRender.hpp"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <complex>
+
+void ColorPalette::getColor(int mode, float t, float& br, float& bg, float& bb) {
+    br = bg = bb = 0.f;
+
+    switch (mode) {
+        case 0: // Classic blue-white
+            br = 9 * (1 - t) * t * t * t;
+            bg = 15 * (1 - t) * (1 - t) * t * t;
+            bb = 8.5f * (1 - t) * (1 - t) * (1 - t) * t;
+            break;
+        case 1: // Fire
+            br = std::min(1.f, t * 3.f);
+            bg = std::max(0.f, std::min(1.f, t * 3.f - 1.f));
+            bb = std::max(0.f, t * 3.f - 2.f);
+            break;
+        case 2: // Ocean
+            br = t * t;
+            bg = t;
+            bb = std::sqrt(t);
+            break;
+        case 3: // Rainbow
+            {
+                float h = t * 6.f;
+                int i = (int)h;
+                float f = h - i;
+                switch (i % 6) {
+                    case 0: br = 1.f; bg = f; bb = 0.f; break;
+                    case 1: br = 1.f - f; bg = 1.f; bb = 0.f; break;
+                    case 2: br = 0.f; bg = 1.f; bb = f; break;
+                    case 3: br = 0.f; bg = 1.f - f; bb = 1.f; break;
+                    case 4: br = f; bg = 0.f; bb = 1.f; break;
+                    case 5: br = 1.f; bg = 0.f; bb = 1.f - f; break;
+                }
+            }
+            break;
+        case 4: // Grayscale
+        default:
+            br = bg = bb = t;
+            break;
+    }
+}
+
+void PaletteLut::update(int colorMode, int maxIter) {
+    if (colorMode == this->colorMode && maxIter == this->maxIter)
+        return;
+    this->colorMode = colorMode;
+    this->maxIter = maxIter;
+
+    rgb.assign((maxIter + 1) * 3, 0);
+    specular.assign(maxIter + 1, 0);
+    for (int iter = 0; iter <= maxIter; iter++) {
+        // Heights used to be stored as iter / maxIter and converted back by truncation,
+        // which loses one iteration for some counts. Keep those colors as they were.
+        float h = (float)iter / (float)maxIter;
+        int heightIter = (int)(h * maxIter);
+        specular[iter] = h > 0.5f;
+        if (heightIter >= maxIter)
+            continue;
+
+        float t = (float)heightIter / (float)maxIter;
+        float c[3];
+        ColorPalette::getColor(colorMode, t, c[0], c[1], c[2]);
+        for (int k = 0; k < 3; k++) {
+            rgb[iter * 3 + k] = (uint16_t)std::lround(clamp(c[k], 0.f, 1.f) * (255.f * 256.f));
+        }
+    }
+}
+
+namespace {
+
+// Brightness for the quantized diffuse term, without and with the specular highlight
+struct BrightnessTable {
+    uint16_t brightness[2][ShadingLut::DIFFUSE_STEPS + 1];
+
+    BrightnessTable() {
+        for (int i = 0; i <= ShadingLut::DIFFUSE_STEPS; i++) {
+            float diffuse = (float)i / ShadingLut::DIFFUSE_STEPS;
+            // Ambient + diffuse
+            float b = 0.3f + 0.7f * diffuse;
+            // Specular highlight for high iteration areas
+            float spec = std::pow(diffuse, 8.f) * 0.5f;
+            brightness[0][i] = (uint16_t)std::lround(b * 4096.f);
+            brightness[1][i] = (uint16_t)std::lround((b + spec) * 4096.f);
+        }
+    }
+};
+
+const BrightnessTable brightnessTable;
+
+} // namespace
+
+// Compute normal from height map gradient, and its diffuse lighting term
+static float diffuseFor(const float* lightDir, int dx, int dy, int maxIter) {
+    float nx = 2.f * dx / maxIter;
+    float ny = 2.f * dy / maxIter;
+    float nz = 0.1f;
+    float nLen = std::sqrt(nx*nx + ny*ny + nz*nz);
+    nx /= nLen; ny /= nLen; nz /= nLen;
+    return std::max(0.f, nx * lightDir[0] + ny * lightDir[1] + nz * lightDir[2]);
+}
+
+void ShadingLut::update(int maxIter, float tilt) {
+    if (maxIter == this->maxIter && tilt == this->tilt)
+        return;
+    this->maxIter = maxIter;
+    this->tilt = tilt;
+
+    lightDir[0] = -0.3f - tilt * 0.5f;
+    lightDir[1] = -0.5f;
+    lightDir[2] = 1.f;
+    float lightLen = std::sqrt(lightDir[0]*lightDir[0] + lightDir[1]*lightDir[1] + lightDir[2]*lightDir[2]);
+    lightDir[0] /= lightLen;
+    lightDir[1] /= lightLen;
+    lightDir[2] /= lightLen;
+
+    for (int dy = -GRADIENT_RANGE; dy <= GRADIENT_RANGE; dy++) {
+        for (int dx = -GRADIENT_RANGE; dx <= GRADIENT_RANGE; dx++) {
+            int i = (int)std::lround(diffuseFor(lightDir, dx, dy, maxIter) * DIFFUSE_STEPS);
+            int idx = (dy + GRADIENT_RANGE) * GRADIENT_SIZE + (dx + GRADIENT_RANGE);
+            gradient[0][idx] = brightnessTable.brightness[0][i];
+            gradient[1][idx] = brightnessTable.brightness[1][i];
+        }
+    }
+}
+
+uint32_t ShadingLut::getBrightness(int dx, int dy, bool specular) const {
+    if (dx >= -GRADIENT_RANGE && dx <= GRADIENT_RANGE && dy >= -GRADIENT_RANGE && dy <= GRADIENT_RANGE)
+        return gradient[specular][(dy + GRADIENT_RANGE) * GRADIENT_SIZE + (dx + GRADIENT_RANGE)];
+    // Steep gradients are rare (only right at the boundary of the set)
+    int i = (int)std::lround(diffuseFor(lightDir, dx, dy, maxIter) * DIFFUSE_STEPS);
+    return brightnessTable.brightness[specular][i];
+}
+
+JuliaFrameKey JuliaParams::key() const {
+    JuliaFrameKey k;
+    // c in steps of 1/16384 at up to 4x zoom, where a pixel is ~0.0065 wide, and finer in
+    // proportion beyond
+    double cScale = 16384.0 * std::max(1.0, zoom / (double)JuliaView::CENTERED_ZOOM);
+    k.cReal = std::llround(cReal * cScale);
+    k.cImag = std::llround(cImag * cScale);
+    // Zoom is multiplicative, so quantize it in octaves
+    k.zoom = (int32_t)std::lround(std::log2(zoom) * 4096.f);
+    k.tilt = (int32_t)std::lround(tilt * 4096.f);
+    k.maxIter = maxIter;
+    k.colorMode = colorMode;
+    return k;
+}
+
+constexpr float JuliaView::CENTERED_ZOOM;
+constexpr float JuliaView::PERTURBATION_ZOOM;
+constexpr float JuliaView::MAX_ZOOM;
+
+JuliaView::JuliaView(const JuliaParams& p, int width, int height, double targetX, double targetY)
+    : width(width), height(height) {
+    float aspectRatio = (float)width / (float)height;
+    xMin = -2.f / p.zoom * aspectRatio;
+    xMax = 2.f / p.zoom * aspectRatio;
+    yMin = -2.f / p.zoom;
+    yMax = 2.f / p.zoom;
+
+    // Tilt creates a perspective transformation
+    // tilt = -1: looking from bottom, tilt = 1: looking from top
+    tiltAngle = p.tilt * 0.5f; // radians
+
+    if (p.zoom > CENTERED_ZOOM) {
+        // The target's distance from the centre shrinks with the square of the zoom, faster
+        // than the view does, so it comes into view by 8x |target| and then settles in the middle
+        double pan = 1.0 - std::pow(CENTERED_ZOOM / (double)p.zoom, 2);
+        centerX = targetX * pan;
+        centerY = targetY * pan;
+    }
+    perturbed = p.zoom > PERTURBATION_ZOOM;
+}
+
+namespace {
+
+// Iterations that decide whether a point belongs to the filled Julia set, when looking
+// for the zoom target
+const int TARGET_ITERATIONS = 1000;
+// Enough to pin the target down to double precision
+const int TARGET_BISECTIONS = 56;
+// How far c may drift from the c the target was found for, times the view's half-height
+// 2 / zoom, before the target is looked for again. Audio modulation scales down with the
+// view, so at moderate depth it stays within this and the view holds still.
+const float TARGET_DRIFT = 0.05f;
+
+bool isBounded(double x, double y, double cReal, double cImag, double radius2) {
+    for (int i = 0; i < TARGET_ITERATIONS; i++) {
+        double x2 = x * x;
+        double y2 = y * y;
+        if (x2 + y2 > radius2)
+            return false;
+        y = 2.0 * x * y + cImag;
+        x = x2 - y2 + cReal;
+    }
+    return true;
+}
+
+} // namespace
+
+void juliaZoomTarget(double cReal, double cImag, double& x, double& y) {
+    // Beyond this radius every orbit escapes
+    double radius2 = std::max(4.0, cReal * cReal + cImag * cImag);
+    if (!isBounded(0.0, 0.0, cReal, cImag, radius2)) {
+        // A Cantor set, without a ray to follow; the fixed point (1 + sqrt(1 - 4c)) / 2 is always in it
+        std::complex<double> beta = 0.5 * (1.0 + std::sqrt(1.0 - 4.0 * std::complex<double>(cReal, cImag)));
+        x = beta.real();
+        y = beta.imag();
+        return;
+    }
+
+    // The origin is in the filled set and the far end of the ray is not, so bisection finds a boundary point
+    const double d = std::sqrt(0.5);
+    double inside = 0.0;
+    double outside = std::sqrt(radius2) + 0.5;
+    for (int i = 0; i < TARGET_BISECTIONS; i++) {
+        double r = 0.5 * (inside + outside);
+        if (isBounded(r * d, r * d, cReal, cImag, radius2))
+            inside = r;
+        else
+            outside = r;
+    }
+    x = inside * d;
+    y = inside * d;
+}
+
+void JuliaReference::compute(double centerX, double centerY, double cReal, double cImag, int maxIter, float pixelSize) {
+    // The direct kernels' 1e-5 is this share of a pixel at 1x zoom
+    periodEpsilon = pixelSize * 4e-4f;
+    x.clear();
+    y.clear();
+    auto appendOrbit = [&](double zx, double zy) {
+        for (int n = 0; ; n++) {
+            x.push_back((float)zx);
+            y.push_back((float)zy);
+            if (n == maxIter || zx * zx + zy * zy > 4.0)
+                break;
+            double zxTemp = zx * zx - zy * zy + cReal;
+            zy = 2.0 * zx * zy + cImag;
+            zx = zxTemp;
+        }
+    };
+    appendOrbit(centerX, centerY);
+    centerLast = (int32_t)x.size() - 1;
+    criticalFirst = (int32_t)x.size();
+    appendOrbit(0.0, 0.0);
+    criticalLast = (int32_t)x.size() - 1;
+}
+
+namespace {
+
+int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+int JuliaScheduler::defaultWorkerCount() {
+    int cores = (int)std::thread::hardware_concurrency();
+    return clamp(cores - 1, 1, 4);
+}
+
+JuliaScheduler::~JuliaScheduler() {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopWorkers(lock);
+}
+
+void JuliaScheduler::start(int workerCount) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->workerCount = std::max(workerCount, 1);
+}
+
+void JuliaScheduler::attach(JuliaRenderer* renderer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    renderers.push_back(renderer);
+    startWorkers();
+}
+
+void JuliaScheduler::detach(JuliaRenderer* renderer) {
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCv.wait(lock, [renderer]() { return !renderer->running; });
+    renderers.erase(std::find(renderers.begin(), renderers.end(), renderer));
+    if (renderers.empty() && backgroundJobs.empty())
+        stopWorkers(lock);
+}
+
+void JuliaScheduler::attach(JuliaBackgroundJob* job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    backgroundJobs.push_back(job);
+    startWorkers();
+}
+
+void JuliaScheduler::detach(JuliaBackgroundJob* job) {
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCv.wait(lock, [job]() { return !job->running; });
+    backgroundJobs.erase(std::find(backgroundJobs.begin(), backgroundJobs.end(), job));
+    if (renderers.empty() && backgroundJobs.empty())
+        stopWorkers(lock);
+}
+
+void JuliaScheduler::startWorkers() {
+    if (!workers.empty())
+        return;
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back([this]() { workerLoop(); });
+}
+
+void JuliaScheduler::stopWorkers(std::unique_lock<std::mutex>& lock) {
+    if (workers.empty())
+        return;
+    std::vector<std::thread> stopping;
+    stopping.swap(workers);
+    quit = true;
+    lock.unlock();
+    cv.notify_all();
+    for (std::thread& t : stopping)
+        t.join();
+    lock.lock();
+    quit = false;
+}
+
+void JuliaScheduler::notify() {
+    // Taking the mutex, only ever held briefly, makes sure a worker about to wait sees the new work
+    { std::lock_guard<std::mutex> lock(mutex); }
+    cv.notify_one();
+}
+
+void JuliaScheduler::TileTask::run() {
+    int i;
+    while ((i = next.fetch_add(1)) < count) {
+        (*fn)(i);
+    }
+}
+
+void JuliaScheduler::parallelFor(int count, const std::function<void(int)>& fn) {
+    TileTask task;
+    task.fn = &fn;
+    task.count = count;
+    bool shared;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shared = count > 1 && workerCount > 1;
+        if (shared)
+            tasks.push_back(&task);
+    }
+    if (shared)
+        cv.notify_all();
+
+    // The calling worker takes tiles too
+    task.run();
+
+    if (shared) {
+        // Helpers may still be finishing their last tile
+        std::unique_lock<std::mutex> lock(mutex);
+        tasks.erase(std::find(tasks.begin(), tasks.end(), &task));
+        doneCv.wait(lock, [&task]() { return task.helpers == 0; });
+    }
+}
+
+JuliaBackgroundJob* JuliaScheduler::pickBackgroundJob() {
+    for (JuliaBackgroundJob* job : backgroundJobs) {
+        if (!job->running && job->hasWork())
+            return job;
+    }
+    return nullptr;
+}
+
+JuliaRenderer* JuliaScheduler::pickJob() {
+    int64_t now = steadyMs();
+    JuliaRenderer* best = nullptr;
+    bool bestVisible = false;
+    for (JuliaRenderer* renderer : renderers) {
+        if (renderer->running || !renderer->hasWork())
+            continue;
+        bool visible = now - renderer->lastSeenMs.load(std::memory_order_relaxed) < VISIBLE_MS;
+        if (!best || (visible && !bestVisible) || (visible == bestVisible && renderer->lastRun < best->lastRun)) {
+            best = renderer;
+            bestVisible = visible;
+        }
+    }
+    return best;
+}
+
+JuliaScheduler::TileTask* JuliaScheduler::pickTask() {
+    for (TileTask* task : tasks) {
+        if (task->next.load(std::memory_order_relaxed) < task->count)
+            return task;
+    }
+    return nullptr;
+}
+
+void JuliaScheduler::workerLoop() {
+    system::setThreadName("JuliaScope render");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // Background jobs first, as they are short and the audio thread waits on their
+        // results. Then other scopes' frames before helping with tiles, since whole jobs
+        // run with less overhead.
+        JuliaBackgroundJob* background = nullptr;
+        JuliaRenderer* job = nullptr;
+        TileTask* task = nullptr;
+        cv.wait(lock, [&]() {
+            return quit || (background = pickBackgroundJob()) || (job = pickJob()) || (task = pickTask());
+        });
+        if (quit)
+            return;
+
+        if (background) {
+            background->running = true;
+            lock.unlock();
+            background->run();
+            lock.lock();
+            background->running = false;
+            doneCv.notify_all();
+        } else if (job) {
+            job->running = true;
+            job->lastRun = ++ticket;
+            job->step(lock);
+            job->running = false;
+            doneCv.notify_all();
+        } else {
+            task->helpers++;
+            lock.unlock();
+            task->run();
+            lock.lock();
+            if (--task->helpers == 0)
+                doneCv.notify_all();
+        }
+    }
+}
+
+JuliaRenderer::JuliaRenderer() : scheduler(juliaScheduler) {
+    for (JuliaFrame& buffer : buffers) {
+        buffer.pixels.assign(DISPLAY_WIDTH * DISPLAY_HEIGHT * 4, 0);
+    }
+    front = &buffers[0];
+    back = &buffers[1];
+    resize(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+
+    scheduler.attach(this);
+}
+
+JuliaRenderer::~JuliaRenderer() {
+    scheduler.detach(this);
+}
+
+void JuliaRenderer::request(const JuliaParams& params, const JuliaRenderOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(scheduler.mutex);
+        if (hasPending)
+            requestsDropped.fetch_add(1, std::memory_order_relaxed);
+        pending = params;
+        pendingOptions = options;
+        hasPending = true;
+    }
+    scheduler.cv.notify_one();
+}
+
+bool JuliaRenderer::acquireFrame() {
+    lastSeenMs.store(steadyMs(), std::memory_order_relaxed);
+    if (!frameReady.load(std::memory_order_acquire))
+        return false;
+    std::swap(front, back);
+    // Hands the old front buffer to the worker as its next back buffer
+    frameReady.store(false, std::memory_order_release);
+    // The renderer may be waiting for the back buffer to publish a finished level
+    scheduler.notify();
+    return true;
+}
+
+JuliaRenderStats JuliaRenderer::getStats() const {
+    JuliaRenderStats stats;
+    stats.iterations = lastIterations.load(std::memory_order_relaxed);
+    stats.naiveIterations = lastNaiveIterations.load(std::memory_order_relaxed);
+    stats.frames = framesEnded.load(std::memory_order_acquire);
+    stats.completed = framesCompleted.load(std::memory_order_relaxed);
+    stats.frameNs = lastFrameNs.load(std::memory_order_relaxed);
+    stats.frameComplete = lastFrameComplete.load(std::memory_order_relaxed);
+    stats.dropped = requestsDropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void JuliaRenderer::endFrame(bool complete) {
+    lastFrameNs.store(frameNs, std::memory_order_relaxed);
+    lastFrameComplete.store(complete, std::memory_order_relaxed);
+    if (complete) {
+        framesCompleted.fetch_add(1, std::memory_order_relaxed);
+        frameTimes.add(frameNs);
+    }
+    framesEnded.fetch_add(1, std::memory_order_release);
+    frameOpen = false;
+}
+
+bool JuliaRenderer::hasWork() const {
+    // Publishing needs the back buffer, which is ours once the UI has taken the previous frame
+    return hasPending || nextStep > 0 || (unpublished && !frameReady.load(std::memory_order_acquire));
+}
+
+void JuliaRenderer::step(std::unique_lock<std::mutex>& lock) {
+    if (hasPending) {
+        if (frameOpen)
+            endFrame(false);
+        current = pending;
+        currentOptions = pendingOptions;
+        if (currentOptions.width != width || currentOptions.height != height)
+            resize(currentOptions.width, currentOptions.height);
+        // A reused frame is cheap enough to skip the coarse levels
+        reusing = canReuse(current, currentOptions);
+        if (reusing)
+            nextStep = 1;
+        else if (currentOptions.progressive)
+            nextStep = std::max(COARSEST_STEP, currentOptions.resolutionStep);
+        else
+            nextStep = currentOptions.resolutionStep;
+        // The levels about to be computed overwrite the kept counts
+        if (!reusing)
+            reuseValid = false;
+        refining = false;
+        unpublished = false;
+        hasPending = false;
+        frameIterations = 0;
+        frameNaiveIterations = 0;
+        frameNs = 0;
+        frameOpen = true;
+        viewReady = false;
+    }
+
+    if (nextStep > 0) {
+        int step = nextStep;
+        bool refine = refining;
+        lock.unlock();
+        auto start = std::chrono::steady_clock::now();
+        if (!viewReady) {
+            prepareView(current);
+            viewReady = true;
+        }
+        // Back is ours until it is published, so once the UI has taken the last frame
+        // the level is shaded as it is computed
+        bool shade = !reusing && !frameReady.load(std::memory_order_acquire);
+        if (reusing)
+            renderReuse(current, currentOptions);
+        else
+            renderLevel(current, currentOptions, step, refine, shade);
+        frameNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        lock.lock();
+        // Stop at the governor's resolution
+        nextStep = step / 2 >= currentOptions.resolutionStep ? step / 2 : 0;
+        refining = true;
+        if (step == 1) {
+            reuseValid = true;
+            reuseParams = current;
+            reuseFrames = reusing ? reuseFrames + 1 : 0;
+            reuseNaiveIterations = frameNaiveIterations;
+        }
+        unpublished = true;
+        shaded = shade;
+        if (nextStep == 0) {
+            lastIterations = frameIterations.load();
+            lastNaiveIterations = frameNaiveIterations.load();
+        }
+    }
+
+    // If the UI hasn't taken the last frame yet, keep refining and publish a finer level later
+    if (unpublished && !frameReady.load(std::memory_order_acquire)) {
+        back->finished = nextStep == 0;
+        lock.unlock();
+        if (!shaded) {
+            auto start = std::chrono::steady_clock::now();
+            shadeFrame(current);
+            frameNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+        finishBack();
+        frameReady.store(true, std::memory_order_release);
+        lock.lock();
+        unpublished = false;
+        if (nextStep == 0)
+            endFrame(true);
+    }
+}
+
+const JuliaQuality JuliaGovernor::LEVELS[JuliaGovernor::LEVEL_COUNT] = {
+    {1, 1.f, 2},
+    {1, 0.7f, 2},
+    {1, 0.5f, 3},
+    {2, 0.5f, 3},
+    {2, 0.35f, 4},
+    {4, 0.25f, 6},
+};
+
+namespace {
+
+// Frame time smoothing per measurement
+const float GOVERNOR_SMOOTHING = 0.3f;
+// Climb to a better level only if it is expected to take less than this share of the budget
+const float GOVERNOR_HEADROOM = 0.7f;
+const int GOVERNOR_SETTLE_FRAMES = 2;
+
+} // namespace
+
+float JuliaGovernor::cost(int level) {
+    const JuliaQuality& q = LEVELS[level];
+    return q.iterScale / (q.resolutionStep * q.resolutionStep);
+}
+
+bool JuliaGovernor::update(const JuliaRenderStats& stats) {
+    if (stats.frames == seenFrames)
+        return false;
+    seenFrames = stats.frames;
+
+    // An abandoned frame only says something once it has already overrun the budget
+    float ms = stats.frameNs * 1e-6f;
+    if (!stats.frameComplete && ms <= budgetMs)
+        return false;
+    averageMs = measured ? averageMs + GOVERNOR_SMOOTHING * (ms - averageMs) : ms;
+    measured = true;
+    if (settle > 0) {
+        settle--;
+        return false;
+    }
+
+    int target = level;
+    if (budgetMs <= 0.f)
+        target = 0;
+    else if (averageMs > budgetMs)
+        target = std::min(level + 1, LEVEL_COUNT - 1);
+    else if (level > 0 && averageMs * cost(level - 1) / cost(level) < budgetMs * GOVERNOR_HEADROOM)
+        target = level - 1;
+    if (target == level)
+        return false;
+
+    // Start from the expected time at the new level rather than the old measurements
+    averageMs *= cost(target) / cost(level);
+    level = target;
+    settle = GOVERNOR_SETTLE_FRAMES;
+    return true;
+}
+
+void JuliaGovernor::apply(JuliaParams& p, JuliaRenderOptions& o) const {
+    const JuliaQuality& q = LEVELS[level];
+    p.maxIter = std::max(16, (int)(p.maxIter * q.iterScale));
+    o.resolutionStep = q.resolutionStep;
+}
+
+namespace {
+
+// Iterates a batch of points of the view, directly or by perturbation
+uint64_t iteratePoints(const JuliaView& view, const JuliaReference& reference, const JuliaParams& p, bool periodicity,
+    const float* x, const float* y, int count, int32_t* iters) {
+    const EscapeKernel& kernel = getEscapeKernel();
+    if (view.perturbed)
+        return kernel.perturb(x, y, count, reference, p.maxIter, periodicity, iters);
+    return kernel.escape(x, y, count, p.cReal, p.cImag, p.maxIter, periodicity, iters);
+}
+
+// Computes one tile of one level. Works on the level's lattice: lattice point
+// (i, j) is pixel (i * step, yBegin + j * step), and each computed point fills its
+// step x step block of the height map, so the frame is complete at any level.
+// Tiles start on multiples of TILE_ROWS, so blocks never cross into another tile.
+struct TileRenderer {
+    static const int MAX_POINTS = JuliaRenderer::TILE_ROWS * MAX_DISPLAY_WIDTH;
+    // Rectangles with fewer lattice points than this across are iterated outright
+    static const int MIN_SUBDIVIDE = 4;
+
+    const JuliaParams& p;
+    const JuliaView& view;
+    const JuliaReference& reference;
+    bool periodicity;
+    uint16_t* iterMap;
+    int width;
+    int yBegin, yEnd, step;
+    // When refining, points on the twice as coarse lattice are already in the height map
+    bool refine;
+    int latticeWidth, latticeHeight;
+
+    float x0[MAX_DISPLAY_WIDTH];
+    float y0[JuliaRenderer::TILE_ROWS];
+    // Lattice points computed (or known from the coarser level) so far
+    uint8_t done[MAX_POINTS];
+
+    // Batch of points waiting for the kernel
+    int batchCount = 0;
+    int batchI[MAX_POINTS];
+    int batchJ[MAX_POINTS];
+    float batchX[MAX_POINTS];
+    float batchY[MAX_POINTS];
+    int32_t batchIters[MAX_POINTS];
+
+    uint64_t iterations = 0;
+    uint64_t naiveIterations = 0;
+
+    TileRenderer(const JuliaParams& p, const JuliaRenderOptions& o, const JuliaView& view, const JuliaReference& reference,
+        uint16_t* iterMap, int yBegin, int yEnd, int step, bool refine)
+        : p(p), view(view), reference(reference), periodicity(o.periodicity), iterMap(iterMap),
+          width(view.width), yBegin(yBegin), yEnd(yEnd), step(step), refine(refine) {
+        latticeWidth = (width + step - 1) / step;
+        latticeHeight = (yEnd - yBegin + step - 1) / step;
+
+        // x0 only depends on the column, y0 only on the row
+        for (int i = 0; i < latticeWidth; i++) {
+            x0[i] = view.x(i * step);
+        }
+        for (int j = 0; j < latticeHeight; j++) {
+            y0[j] = view.y(yBegin + j * step);
+        }
+
+        for (int j = 0; j < latticeHeight; j++) {
+            for (int i = 0; i < latticeWidth; i++) {
+                done[j * latticeWidth + i] = isKnown(i, j);
+            }
+        }
+    }
+
+    bool isKnown(int i, int j) const {
+        int py = yBegin + j * step;
+        return refine && (i * step) % (2 * step) == 0 && py % (2 * step) == 0;
+    }
+
+    uint16_t iterAt(int i, int j) const {
+        return iterMap[(yBegin + j * step) * width + i * step];
+    }
+
+    void fillBlock(int i, int j, int32_t iter) {
+        int px = i * step;
+        int py = yBegin + j * step;
+        int pxEnd = std::min(px + step, width);
+        int pyEnd = std::min(py + step, yEnd);
+        for (int by = py; by < pyEnd; by++) {
+            for (int bx = px; bx < pxEnd; bx++) {
+                iterMap[by * width + bx] = (uint16_t)iter;
+            }
+        }
+    }
+
+    void add(int i, int j) {
+        uint8_t& d = done[j * latticeWidth + i];
+        if (d)
+            return;
+        d = 1;
+        batchI[batchCount] = i;
+        batchJ[batchCount] = j;
+        batchX[batchCount] = x0[i];
+        batchY[batchCount] = y0[j];
+        batchCount++;
+    }
+
+    void flush() {
+        if (batchCount == 0)
+            return;
+        iterations += iteratePoints(view, reference, p, periodicity, batchX, batchY, batchCount, batchIters);
+        for (int k = 0; k < batchCount; k++) {
+            naiveIterations += batchIters[k];
+            fillBlock(batchI[k], batchJ[k], batchIters[k]);
+        }
+        batchCount = 0;
+    }
+
+    void renderAll() {
+        for (int j = 0; j < latticeHeight; j++) {
+            for (int i = 0; i < latticeWidth; i++) {
+                add(i, j);
+            }
+        }
+        flush();
+    }
+
+    // Mariani-Silver subdivision of the lattice rectangle [i0, i1] x [j0, j1]
+    void subdivide(int i0, int j0, int i1, int j1) {
+        for (int i = i0; i <= i1; i++) {
+            add(i, j0);
+            add(i, j1);
+        }
+        for (int j = j0 + 1; j < j1; j++) {
+            add(i0, j);
+            add(i1, j);
+        }
+        flush();
+
+        if (i1 - i0 < 2 || j1 - j0 < 2)
+            return;
+
+        // A uniform border means the whole rectangle shares its escape count
+        int32_t iter = iterAt(i0, j0);
+        bool uniform = true;
+        for (int i = i0; i <= i1 && uniform; i++) {
+            uniform = iterAt(i, j0) == iter && iterAt(i, j1) == iter;
+        }
+        for (int j = j0 + 1; j < j1 && uniform; j++) {
+            uniform = iterAt(i0, j) == iter && iterAt(i1, j) == iter;
+        }
+
+        if (uniform) {
+            for (int j = j0 + 1; j < j1; j++) {
+                for (int i = i0 + 1; i < i1; i++) {
+                    uint8_t& d = done[j * latticeWidth + i];
+                    if (d)
+                        continue;
+                    d = 1;
+                    naiveIterations += iter;
+                    fillBlock(i, j, iter);
+                }
+            }
+            return;
+        }
+
+        if (i1 - i0 < MIN_SUBDIVIDE || j1 - j0 < MIN_SUBDIVIDE) {
+            for (int j = j0 + 1; j < j1; j++) {
+                for (int i = i0 + 1; i < i1; i++) {
+                    add(i, j);
+                }
+            }
+            flush();
+            return;
+        }
+
+        // Split across the longer side; the halves share the dividing line
+        if (i1 - i0 >= j1 - j0) {
+            int mid = (i0 + i1) / 2;
+            subdivide(i0, j0, mid, j1);
+            subdivide(mid, j0, i1, j1);
+        } else {
+            int mid = (j0 + j1) / 2;
+            subdivide(i0, j0, i1, mid);
+            subdivide(i0, mid, i1, j1);
+        }
+    }
+};
+
+} // namespace
+
+void JuliaRenderer::prepareView(const JuliaParams& p) {
+    // c moves with the audio on nearly every frame, but finding the target takes a while
+    // and every new one shifts the view, so it is latched when the zoom passes
+    // CENTERED_ZOOM, where the view doesn't pan yet, and only found again once c has
+    // drifted a visible distance from it
+    if (p.zoom > JuliaView::CENTERED_ZOOM) {
+        float tolerance = TARGET_DRIFT * 2.f / p.zoom;
+        if (!hasTarget || std::abs(p.cReal - targetCReal) > tolerance || std::abs(p.cImag - targetCImag) > tolerance) {
+            juliaZoomTarget(p.cReal, p.cImag, targetX, targetY);
+            hasTarget = true;
+            targetCReal = p.cReal;
+            targetCImag = p.cImag;
+        }
+    } else {
+        hasTarget = false;
+    }
+    view = JuliaView(p, width, height, targetX, targetY);
+    if (view.perturbed)
+        reference.compute(view.centerX, view.centerY, p.cReal, p.cImag, p.maxIter, (view.xMax - view.xMin) / width);
+}
+
+void JuliaRenderer::renderLevel(const JuliaParams& p, const JuliaRenderOptions& o, int step, bool refine, bool shade) {
+    int tileCount = (height + TILE_ROWS - 1) / TILE_ROWS;
+    if (shade)
+        prepareShading(p);
+
+    scheduler.parallelFor(tileCount, [&](int tile) {
+        int y0 = tile * TILE_ROWS;
+        int y1 = std::min(y0 + TILE_ROWS, height);
+        // About 100 KB, too much for the stack of every worker
+        std::unique_ptr<TileRenderer> t(new TileRenderer(p, o, view, reference, iterMap.data(), y0, y1, step, refine));
+        if (o.boundaryTrace)
+            t->subdivide(0, 0, t->latticeWidth - 1, t->latticeHeight - 1);
+        else
+            t->renderAll();
+        frameIterations += t->iterations;
+        frameNaiveIterations += t->naiveIterations;
+
+        // Rows whose neighbours are all in this tile can be lit right away; the first and
+        // last rows wait for the tiles above and below
+        if (shade)
+            shadeRows(p, y0 > 0 ? y0 + 1 : y0, y1 < height ? y1 - 1 : y1);
+    });
+
+    if (shade) {
+        scheduler.parallelFor(tileCount, [&](int tile) {
+            int y0 = tile * TILE_ROWS;
+            int y1 = std::min(y0 + TILE_ROWS, height);
+            if (y0 > 0)
+                shadeRows(p, y0, y0 + 1);
+            if (y1 < height)
+                shadeRows(p, y1 - 1, y1);
+        });
+    }
+}
+
+namespace {
+
+// Largest distance c may move between frames that reuse counts
+const float REUSE_MAX_JUMP = 0.01f;
+// Points per kernel call when re-iterating
+const int REUSE_BATCH = 256;
+
+} // namespace
+
+bool JuliaRenderer::canReuse(const JuliaParams& p, const JuliaRenderOptions& o) const {
+    if (!o.temporalReuse || !reuseValid || o.resolutionStep != 1 || reuseFrames >= REUSE_REFRESH_FRAMES)
+        return false;
+    // Deeper, the view centre follows c, so the kept counts belong to other points
+    if (p.zoom > JuliaView::CENTERED_ZOOM || reuseParams.zoom > JuliaView::CENTERED_ZOOM)
+        return false;
+    // The kept counts belong to one view and iteration cap; steps below the frame key's count as the same view
+    JuliaFrameKey key = p.key();
+    JuliaFrameKey reuseKey = reuseParams.key();
+    if (key.zoom != reuseKey.zoom || key.tilt != reuseKey.tilt || p.maxIter != reuseParams.maxIter)
+        return false;
+    return std::hypot(p.cReal - reuseParams.cReal, p.cImag - reuseParams.cImag) <= REUSE_MAX_JUMP;
+}
+
+void JuliaRenderer::renderReuse(const JuliaParams& p, const JuliaRenderOptions& o) {
+    const int W = width;
+    const int H = height;
+    int tileCount = (H + TILE_ROWS - 1) / TILE_ROWS;
+    uint16_t* iters = iterMap.data();
+    uint8_t* marked = reuseMarked.data();
+    std::fill(reuseMarked.begin(), reuseMarked.end(), 0);
+
+    auto mark = [&](int index) {
+        if (marked[index])
+            return;
+        marked[index] = 1;
+        reuseQueues[index / (W * TILE_ROWS)].push_back(ReusePoint{index, iters[index]});
+    };
+
+    // Queue both sides of every contour of the previous frame, where a count differs
+    // from its right or lower neighbour
+    for (int y = 0; y < H; y++) {
+        const uint16_t* row = iters + y * W;
+        for (int x = 0; x < W; x++) {
+            int index = y * W + x;
+            if (x + 1 < W && row[x + 1] != row[x]) {
+                mark(index);
+                mark(index + 1);
+            }
+            if (y + 1 < H && row[x + W] != row[x]) {
+                mark(index);
+                mark(index + W);
+            }
+        }
+    }
+
+    // The frame's naive count is the previous one's plus the change of every re-iterated pixel
+    frameNaiveIterations = reuseNaiveIterations;
+    while (true) {
+        scheduler.parallelFor(tileCount, [&](int tile) {
+            // In scan order, so neighbouring points with similar counts share SIMD groups
+            const std::vector<ReusePoint>& queue = reuseQueues[tile];
+
+            float batchX[REUSE_BATCH];
+            float batchY[REUSE_BATCH];
+            int32_t batchIters[REUSE_BATCH];
+            uint64_t iterations = 0;
+            int64_t naiveChange = 0;
+            for (size_t begin = 0; begin < queue.size(); begin += REUSE_BATCH) {
+                int count = (int)std::min<size_t>(REUSE_BATCH, queue.size() - begin);
+                for (int k = 0; k < count; k++) {
+                    int index = queue[begin + k].index;
+                    batchX[k] = view.x(index % W);
+                    batchY[k] = view.y(index / W);
+                }
+                iterations += iteratePoints(view, reference, p, o.periodicity, batchX, batchY, count, batchIters);
+                for (int k = 0; k < count; k++) {
+                    const ReusePoint& point = queue[begin + k];
+                    iters[point.index] = (uint16_t)batchIters[k];
+                    naiveChange += batchIters[k] - point.previous;
+                }
+            }
+            frameIterations += iterations;
+            frameNaiveIterations += (uint64_t)naiveChange;
+        });
+
+        reuseRound.clear();
+        for (std::vector<ReusePoint>& queue : reuseQueues) {
+            reuseRound.insert(reuseRound.end(), queue.begin(), queue.end());
+            queue.clear();
+        }
+
+        // A changed count means a contour may have moved past the queued pixels, so its
+        // neighbours are re-iterated too, until no count at the edge of the region changes
+        bool grown = false;
+        for (const ReusePoint& point : reuseRound) {
+            if (iters[point.index] == point.previous)
+                continue;
+            int x = point.index % W;
+            int y = point.index / W;
+            for (int ny = std::max(0, y - 1); ny <= std::min(H - 1, y + 1); ny++) {
+                for (int nx = std::max(0, x - 1); nx <= std::min(W - 1, x + 1); nx++) {
+                    int index = ny * W + nx;
+                    if (!marked[index]) {
+                        mark(index);
+                        grown = true;
+                    }
+                }
+            }
+        }
+        if (!grown)
+            break;
+    }
+}
+
+void JuliaRenderer::resize(int width, int height) {
+    this->width = width;
+    this->height = height;
+    iterMap.assign(width * height, 0);
+    reuseMarked.assign(width * height, 0);
+    reuseQueues.resize((height + TILE_ROWS - 1) / TILE_ROWS);
+    dirtyRows.resize(height);
+    // The kept counts are for another grid
+    reuseValid = false;
+}
+
+void JuliaRenderer::prepareShading(const JuliaParams& p) {
+    palette.update(p.colorMode, p.maxIter);
+    shading.update(p.maxIter, p.tilt);
+    if (back->width != width || back->height != height) {
+        back->width = width;
+        back->height = height;
+        back->pixels.resize(width * height * 4);
+    }
+}
+
+void JuliaRenderer::finishBack() {
+    back->generation = ++generation;
+    // Another size replaces the whole image
+    bool resized = back->width != front->width || back->height != front->height;
+    int x0 = back->width, x1 = 0, y0 = back->height, y1 = 0;
+    for (int y = 0; y < back->height; y++) {
+        const RowSpan& span = dirtyRows[y];
+        if (!resized && span.begin == span.end)
+            continue;
+        x0 = std::min(x0, resized ? 0 : (int)span.begin);
+        x1 = std::max(x1, resized ? back->width : (int)span.end);
+        y0 = std::min(y0, y);
+        y1 = y + 1;
+    }
+    back->dirtyX = x0 < x1 ? x0 : 0;
+    back->dirtyY = x0 < x1 ? y0 : 0;
+    back->dirtyWidth = std::max(0, x1 - x0);
+    back->dirtyHeight = x0 < x1 ? y1 - y0 : 0;
+}
+
+void JuliaRenderer::shadeFrame(const JuliaParams& p) {
+    int tileCount = (height + TILE_ROWS - 1) / TILE_ROWS;
+    prepareShading(p);
+
+    // For levels rendered while the back buffer was still waiting for the UI, and for
+    // reused frames, whose counts change at scattered pixels
+    scheduler.parallelFor(tileCount, [&](int tile) {
+        int y0 = tile * TILE_ROWS;
+        shadeRows(p, y0, std::min(y0 + TILE_ROWS, height));
+    });
+}
+
+void JuliaRenderer::shadeRows(const JuliaParams& p, int yBegin, int yEnd) {
+    uint8_t* pixels = back->pixels.data();
+    // The front buffer only changes when the UI takes the back one, so it is safe to read here
+    const uint32_t* previous = front->width == width && front->height == height
+        ? (const uint32_t*)front->pixels.data() : nullptr;
+
+    for (int py = yBegin; py < yEnd; py++) {
+        const uint16_t* row = &iterMap[py * width];
+        const uint16_t* rowU = py > 0 ? row - width : row;
+        const uint16_t* rowD = py < height-1 ? row + width : row;
+
+        for (int px = 0; px < width; px++) {
+            int iter = row[px];
+
+            // Height map gradient, in iterations
+            int iL = px > 0 ? row[px-1] : iter;
+            int iR = px < width-1 ? row[px+1] : iter;
+            uint32_t brightness = shading.getBrightness(iL - iR, rowU[px] - rowD[px], palette.specular[iter]);
+
+            // Color (8.8) times brightness (4.12), down to 8 bits
+            const uint16_t* c = &palette.rgb[iter * 3];
+            int idx = (py * width + px) * 4;
+            pixels[idx + 0] = (uint8_t)std::min<uint32_t>(255, (c[0] * brightness) >> 20);
+            pixels[idx + 1] = (uint8_t)std::min<uint32_t>(255, (c[1] * brightness) >> 20);
+            pixels[idx + 2] = (uint8_t)std::min<uint32_t>(255, (c[2] * brightness) >> 20);
+            pixels[idx + 3] = 255;
+        }
+
+        // The changed span of the row, while it is still in cache
+        RowSpan& span = dirtyRows[py];
+        if (!previous) {
+            span.begin = 0;
+            span.end = (int16_t)width;
+            continue;
+        }
+        const uint32_t* shaded = (const uint32_t*)pixels + py * width;
+        const uint32_t* old = previous + py * width;
+        int begin = 0;
+        int end = width;
+        while (begin < end && shaded[begin] == old[begin])
+            begin++;
+        while (end > begin && shaded[end - 1] == old[end - 1])
+            end--;
+        span.begin = (int16_t)begin;
+        span.end = (int16_t)end;
+    }
+}
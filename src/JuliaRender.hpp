@@ -0,0 +1,518 @@
+#pragma once
+#include "plugin.hpp"
+#include "PerfCounters.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// Standard frame size. With "Render at screen resolution" a frame can be up to
+// MAX_DISPLAY_SCALE times as wide and high, in the same aspect ratio.
+static const int DISPLAY_WIDTH = 200;
+static const int DISPLAY_HEIGHT = 155;
+static const int MAX_DISPLAY_SCALE = 2;
+static const int MAX_DISPLAY_WIDTH = DISPLAY_WIDTH * MAX_DISPLAY_SCALE;
+static const int MAX_DISPLAY_HEIGHT = DISPLAY_HEIGHT * MAX_DISPLAY_SCALE;
+
+// JuliaParams rounded to steps well below one pixel, so envelope jitter that
+// can't change the picture doesn't trigger a re-render
+struct JuliaFrameKey {
+    // c is quantized relative to the pixel size, which takes more than 32 bits at deep zoom
+    int64_t cReal, cImag;
+    int32_t zoom, tilt, maxIter, colorMode;
+
+    bool operator==(const JuliaFrameKey& other) const {
+        return cReal == other.cReal && cImag == other.cImag && zoom == other.zoom
+            && tilt == other.tilt && maxIter == other.maxIter && colorMode == other.colorMode;
+    }
+    bool operator!=(const JuliaFrameKey& other) const { return !(*this == other); }
+};
+
+// Everything the renderer needs for one frame, captured on the UI thread
+struct JuliaParams {
+    float cReal = -0.7f;
+    float cImag = 0.27015f;
+    // Up to JuliaView::MAX_ZOOM
+    float zoom = 1.f;
+    float tilt = 0.f;
+    int maxIter = 64;
+    int colorMode = 0;
+
+    JuliaFrameKey key() const;
+};
+
+// How the renderer computes a frame; set from the module's context menu
+struct JuliaRenderOptions {
+    // Show a coarse frame first and refine it over the next frames
+    bool progressive = true;
+    // Stop iterating orbits that have fallen into an attracting cycle
+    bool periodicity = true;
+    // Mariani-Silver: iterate only the border of a rectangle and fill it if the border is uniform.
+    // Not exact, since a filament thinner than the rectangle can be filled over, so off by default.
+    bool boundaryTrace = false;
+    // Iterate every resolutionStep-th pixel across and down, and fill the blocks in between
+    // (1, 2 or 4). Set by the frame-time governor.
+    int resolutionStep = 1;
+    // Start from the previous frame's iteration counts when c has only moved a little
+    bool temporalReuse = true;
+    // Frame size in pixels, at most MAX_DISPLAY_WIDTH x MAX_DISPLAY_HEIGHT. Set by the display.
+    int width = DISPLAY_WIDTH;
+    int height = DISPLAY_HEIGHT;
+};
+
+// Iteration counts of the last completed frame, and the cost of the last frame the
+// renderer finished or abandoned
+struct JuliaRenderStats {
+    // Iterations actually run
+    uint64_t iterations = 0;
+    // Iterations a plain escape-time loop over every pixel would have run
+    uint64_t naiveIterations = 0;
+    // Time the worker spent rendering and shading the frame, over all its levels
+    uint64_t frameNs = 0;
+    // Whether that frame was finished; an abandoned one only gives a lower bound
+    bool frameComplete = false;
+    // Frames finished or abandoned so far, to tell new measurements from old ones
+    uint32_t frames = 0;
+    // Frames finished so far
+    uint32_t completed = 0;
+    // Requests superseded by a newer one before a worker started them
+    uint32_t dropped = 0;
+};
+
+// One step of the governor's quality ladder
+struct JuliaQuality {
+    int resolutionStep;
+    // Fraction of ITER actually iterated
+    float iterScale;
+    // Request a frame every frameSkip UI frames
+    int frameSkip;
+};
+
+// Adjusts render quality to keep the time per frame within a budget. Drops one step down
+// the ladder whenever the smoothed frame time is over budget, and climbs back one step
+// when the next better level is expected to fit with room to spare. Runs on the UI thread.
+struct JuliaGovernor {
+    static const int LEVEL_COUNT = 6;
+    static const JuliaQuality LEVELS[LEVEL_COUNT];
+
+    // Milliseconds per frame; 0 keeps the best quality
+    float budgetMs = 4.f;
+
+    // UI thread: account for the renderer's latest measurement, if it has a new one.
+    // Returns whether the quality level changed.
+    bool update(const JuliaRenderStats& stats);
+    // UI thread: the parameters and options to render at the current level
+    void apply(JuliaParams& p, JuliaRenderOptions& o) const;
+
+    int getLevel() const { return level; }
+    const JuliaQuality& getQuality() const { return LEVELS[level]; }
+    float getAverageMs() const { return averageMs; }
+
+private:
+    // Relative cost of a level, the fraction of full-quality iterations it runs
+    static float cost(int level);
+
+    int level = 0;
+    float averageMs = 0.f;
+    bool measured = false;
+    // Measurements still to skip after a level change, from frames requested before it
+    int settle = 0;
+    uint32_t seenFrames = 0;
+};
+
+// Color palette functions
+struct ColorPalette {
+    // Unlit color at t = iter / maxIter, components in [0, 1]
+    static void getColor(int mode, float t, float& r, float& g, float& b);
+};
+
+// One palette baked per iteration count, so shading needs no per-pixel palette math.
+// Rebuilt only when the palette or the iteration count changes.
+struct PaletteLut {
+    int colorMode = -1;
+    int maxIter = -1;
+    // Color components scaled by 255 * 256, 3 per iteration; maxIter is black
+    std::vector<uint16_t> rgb;
+    // Whether the iteration count is high enough for the specular highlight
+    std::vector<uint8_t> specular;
+
+    void update(int colorMode, int maxIter);
+};
+
+// Lighting in fixed point: brightness is in 1/4096 units. Brightness only depends on the
+// diffuse term, which is quantized into a static table. The diffuse term only depends on
+// the iteration gradient, so small gradients get their brightness from a second table,
+// rebuilt when the iteration count or the light direction (tilt) changes.
+struct ShadingLut {
+    static const int DIFFUSE_STEPS = 4096;
+    static const int GRADIENT_RANGE = 16;
+    static const int GRADIENT_SIZE = 2 * GRADIENT_RANGE + 1;
+
+    int maxIter = -1;
+    float tilt = 0.f;
+    float lightDir[3];
+    // Indexed by [specular][dy + GRADIENT_RANGE][dx + GRADIENT_RANGE]
+    uint16_t gradient[2][GRADIENT_SIZE * GRADIENT_SIZE];
+
+    void update(int maxIter, float tilt);
+    // dx, dy: iteration count left minus right, up minus down
+    uint32_t getBrightness(int dx, int dy, bool specular) const;
+};
+
+// Escape-time kernel for a batch of points. Writes the iteration count of every
+// point, capped at maxIter, and returns the number of iterations actually run.
+// With periodicity set, orbits caught in a cycle stop early and count as maxIter.
+typedef uint64_t (*EscapeFn)(const float* x0, const float* y0, int count, float cReal, float cImag, int maxIter, bool periodicity, int32_t* iters);
+
+// Reference orbits for perturbation, computed in double precision and stored in float.
+// x and y hold the orbit of the view centre, entries 0 to centerLast, followed by the
+// orbit of the critical point 0, entries criticalFirst to criticalLast. Each orbit ends
+// at maxIter or at its first point outside radius 2.
+struct JuliaReference {
+    std::vector<float> x, y;
+    int32_t centerLast = 0;
+    int32_t criticalFirst = 0;
+    int32_t criticalLast = 0;
+    // Periodicity tolerance. A fixed one would catch pixels that merely start close to a
+    // repelling cycle once pixels get that small, so it is kept in proportion to the pixel size.
+    float periodEpsilon = 0.f;
+
+    void compute(double centerX, double centerY, double cReal, double cImag, int maxIter, float pixelSize);
+};
+
+// Perturbation kernel: the same as an escape kernel for the points centre + (dx0, dy0),
+// but iterates each point's offset from the reference orbit, so offsets far below float
+// precision of the point itself stay exact. A point whose orbit comes closer to 0 than to
+// its reference, where the offset would lose precision, or that runs past the end of its
+// reference, is rebased onto the critical orbit.
+typedef uint64_t (*PerturbFn)(const float* dx0, const float* dy0, int count, const JuliaReference& reference, int maxIter, bool periodicity, int32_t* iters);
+
+struct EscapeKernel {
+    const char* name;
+    EscapeFn escape;
+    PerturbFn perturb;
+};
+
+uint64_t escapeScalar(const float* x0, const float* y0, int count, float cReal, float cImag, int maxIter, bool periodicity, int32_t* iters);
+uint64_t perturbScalar(const float* dx0, const float* dy0, int count, const JuliaReference& reference, int maxIter, bool periodicity, int32_t* iters);
+// Kernels this CPU can run, fastest first. The last one is always the scalar fallback.
+const std::vector<EscapeKernel>& getSupportedEscapeKernels();
+// Fastest supported kernel, detected once
+const EscapeKernel& getEscapeKernel();
+
+// Maps pixels to points of the complex plane. Up to CENTERED_ZOOM the view is centred on
+// the origin. Deeper, it pans towards a point of the Julia set while zooming, so there is
+// always detail to zoom into. Past PERTURBATION_ZOOM, float points would be too coarse, so
+// the centre is kept in double precision and x() and y() give float offsets from it.
+struct JuliaView {
+    static constexpr float CENTERED_ZOOM = 4.f;
+    static constexpr float PERTURBATION_ZOOM = 16.f;
+    // 2^40; a pixel is then about 100 double ulps wide
+    static constexpr float MAX_ZOOM = 1099511627776.f;
+
+    double centerX = 0.0;
+    double centerY = 0.0;
+    // Offsets of the view's edges from the centre
+    float xMin = 0.f, xMax = 0.f, yMin = 0.f, yMax = 0.f;
+    float tiltAngle = 0.f;
+    bool perturbed = false;
+    // Frame size in pixels
+    int width = DISPLAY_WIDTH;
+    int height = DISPLAY_HEIGHT;
+
+    JuliaView() {}
+    // target is the Julia set point that deep zooms close in on, see juliaZoomTarget()
+    JuliaView(const JuliaParams& p, int width, int height, double targetX, double targetY);
+
+    float x(int px) const {
+        float offset = xMin + (xMax - xMin) * px / (float)width;
+        return perturbed ? offset : (float)centerX + offset;
+    }
+
+    float y(int py) const {
+        // Apply perspective based on tilt
+        float normY = (float)py / (float)height;
+        float perspectiveScale = 1.f + tiltAngle * (normY - 0.5f) * 0.5f;
+        float offset = (yMin + (yMax - yMin) * py / (float)height) * perspectiveScale;
+        return perturbed ? offset : (float)centerY + offset;
+    }
+};
+
+// A point on the boundary of the filled Julia set of c: where the ray from the origin at
+// 45 degrees leaves it, or the repelling fixed point if the set is disconnected. Costs up
+// to a few hundred thousand double iterations.
+void juliaZoomTarget(double cReal, double cImag, double& x, double& y);
+
+struct JuliaRenderer;
+
+// Work for the render workers besides frames, such as a scope's pitch analysis. Background
+// jobs go ahead of frames, so each run() should be short.
+struct JuliaBackgroundJob {
+    virtual ~JuliaBackgroundJob() {}
+    // Scheduler lock held: whether run() has anything to do
+    virtual bool hasWork() const = 0;
+    // Worker, without the lock; never runs on two workers at once
+    virtual void run() = 0;
+
+private:
+    friend struct JuliaScheduler;
+    // Guarded by the scheduler's mutex
+    bool running = false;
+};
+
+// Render workers shared by every JuliaRenderer in the process, so any number of scopes
+// take turns on a fixed set of threads instead of each bringing its own.
+//
+// A renderer with work is a job. A worker runs one refinement level of the job it picks
+// and then picks again, so scopes interleave level by level. Renderers the UI has shown
+// within VISIBLE_MS go first, and among those the one that ran least recently. Each
+// renderer holds at most one request, so parameters superseded before a worker gets to
+// them are dropped unrendered. Workers without a job help with another job's tiles.
+// Background jobs with work go before any renderer.
+//
+// The plugin owns the one instance, juliaScheduler. Workers are spawned when the first
+// renderer or background job attaches and joined when the last one detaches, so a patch
+// without a scope costs no threads and none are left running when the plugin is unloaded.
+struct JuliaScheduler {
+    static const int VISIBLE_MS = 250;
+
+    // All cores but one, which is left for the audio engine, and at most four
+    static int defaultWorkerCount();
+
+    ~JuliaScheduler();
+
+    // Plugin init: the number of workers to spawn
+    void start(int workerCount);
+    // UI thread: called by the renderer's constructor and destructor. Detaching waits
+    // for a worker still running the renderer.
+    void attach(JuliaRenderer* renderer);
+    void detach(JuliaRenderer* renderer);
+    // Any thread but audio: a background job joins or leaves the workers. Detaching waits
+    // for a worker still running the job.
+    void attach(JuliaBackgroundJob* job);
+    void detach(JuliaBackgroundJob* job);
+    // Any thread: a renderer has new work
+    void notify();
+    // Audio thread: a background job has new work. Wakes a worker without taking the lock,
+    // so a worker just about to wait can miss it; the job then runs on the next notification.
+    void notifyRealtime() { cv.notify_one(); }
+    // Worker: runs fn(i) for every i in [0, count) on this and any idle workers, and
+    // returns once all are done
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+    int getWorkerCount() const { return workerCount; }
+
+private:
+    friend struct JuliaRenderer;
+
+    // Tiles of one parallelFor() call
+    struct TileTask {
+        const std::function<void(int)>* fn;
+        int count;
+        std::atomic<int> next{0};
+        int helpers = 0;
+        void run();
+    };
+
+    void workerLoop();
+    void startWorkers();
+    void stopWorkers(std::unique_lock<std::mutex>& lock);
+    JuliaBackgroundJob* pickBackgroundJob();
+    JuliaRenderer* pickJob();
+    TileTask* pickTask();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    // Signalled when a renderer or a tile task is released by its workers
+    std::condition_variable doneCv;
+    std::vector<std::thread> workers;
+    int workerCount = 1;
+    bool quit = false;
+    std::vector<JuliaRenderer*> renderers;
+    std::vector<JuliaBackgroundJob*> backgroundJobs;
+    std::vector<TileTask*> tasks;
+    // Incremented for every job run, to find the renderer that waited longest
+    uint64_t ticket = 0;
+};
+
+extern JuliaScheduler juliaScheduler;
+
+// A shaded frame as handed to the UI
+struct JuliaFrame {
+    // RGBA, width x height
+    std::vector<uint8_t> pixels;
+    int width = DISPLAY_WIDTH;
+    int height = DISPLAY_HEIGHT;
+    // Counts the frames published. Each one differs from the one numbered before it only
+    // inside the dirty rectangle, which is empty if nothing changed.
+    uint32_t generation = 0;
+    int dirtyX = 0, dirtyY = 0, dirtyWidth = 0, dirtyHeight = 0;
+    // Whether this is the last level of its frame, as opposed to a coarse progressive one
+    bool finished = true;
+};
+
+// Renders the Julia set on the shared JuliaScheduler workers, split into row tiles that
+// idle workers can help with. Finished frames are handed to the UI thread through a
+// front/back buffer pair, so the UI never waits on a render. While shading a row into
+// the back buffer, the worker compares it with the same row of the front buffer, which
+// the UI only reads, so every frame comes with the rectangle that changed since the
+// previous one and the UI can upload just that.
+//
+// In progressive mode a frame is computed on a 4x4, then 2x2, then 1x1 pixel grid.
+// Each level only iterates the pixels the coarser ones skipped, and is published
+// as soon as the UI has taken the previous frame.
+//
+// With temporal reuse, a frame whose c is close to the previous one's keeps the old
+// iteration counts and only re-iterates the pixels around contours of the old height map,
+// growing that band wherever a count turns out to have changed. Every REUSE_REFRESH_FRAMES
+// frames, or after a large jump, the frame is computed from scratch again.
+//
+// Past JuliaView::PERTURBATION_ZOOM, each frame computes reference orbits in double
+// precision and iterates the pixels with the perturbation kernel.
+struct JuliaRenderer {
+    static const int TILE_ROWS = 16;
+    static const int COARSEST_STEP = 4;
+    static const int REUSE_REFRESH_FRAMES = 16;
+
+    JuliaRenderer();
+    ~JuliaRenderer();
+
+    // UI thread: queue a frame, replacing any request no worker has started yet.
+    // A frame still being refined is abandoned in favour of the new one.
+    void request(const JuliaParams& params, const JuliaRenderOptions& options);
+    // UI thread: swap in the most recently finished frame. Returns false if there is none.
+    // Also marks the renderer as visible to the scheduler, so call it on every drawn frame.
+    bool acquireFrame();
+    // UI thread: the frame to upload. Owned by the UI until the next acquireFrame().
+    const JuliaFrame& getFrame() const { return *front; }
+    const uint8_t* getPixels() const { return front->pixels.data(); }
+    // Any thread: iteration counts of the last fully refined frame
+    JuliaRenderStats getStats() const;
+    // UI thread: render times of finished frames, over the last FRAME_TIME_WINDOW of them.
+    // Returns false until that many have finished.
+    bool getFrameTimes(PerfSummary& summary) { return frameTimes.read(summary); }
+
+    static const int FRAME_TIME_WINDOW = 32;
+
+private:
+    friend struct JuliaScheduler;
+
+    // Scheduler lock held: whether a worker has anything to do
+    bool hasWork() const;
+    // Worker, scheduler lock held: start a pending frame, render its next level and publish
+    // whatever the UI has room for. The lock is released while rendering.
+    void step(std::unique_lock<std::mutex>& lock);
+    // Worker: publish the time spent on the current frame
+    void endFrame(bool complete);
+    // With shade set, also shades each tile into the back buffer while its counts are still in cache
+    void renderLevel(const JuliaParams& p, const JuliaRenderOptions& o, int step, bool refine, bool shade);
+    // Worker: set up the view of the current frame, and its reference orbits when perturbed
+    void prepareView(const JuliaParams& p);
+    bool canReuse(const JuliaParams& p, const JuliaRenderOptions& o) const;
+    void renderReuse(const JuliaParams& p, const JuliaRenderOptions& o);
+    // Worker: size the height map and reuse state for a new frame size
+    void resize(int width, int height);
+    // Worker: update the shading tables and size the back buffer for the current frame
+    void prepareShading(const JuliaParams& p);
+    // Worker, scheduler lock held: fill in the back buffer's generation and dirty
+    // rectangle from the shaded rows, just before it is published
+    void finishBack();
+    void shadeFrame(const JuliaParams& p);
+    void shadeRows(const JuliaParams& p, int yBegin, int yEnd);
+
+    JuliaScheduler& scheduler;
+
+    // Guarded by the scheduler's mutex: the latest request, whether a worker is running
+    // this renderer, and the scheduler ticket of its last run
+    JuliaParams pending;
+    JuliaRenderOptions pendingOptions;
+    bool hasPending = false;
+    bool running = false;
+    uint64_t lastRun = 0;
+    // Steady clock milliseconds of the last acquireFrame()
+    std::atomic<int64_t> lastSeenMs{0};
+
+    // Worker state: the frame being refined, the grid step of its next level
+    // (0 once complete), whether a coarser level is already in iterMap, whether
+    // iterMap holds a level not yet published, whether back already shows it, and
+    // whether view has been set up for it
+    JuliaParams current;
+    JuliaRenderOptions currentOptions;
+    int nextStep = 0;
+    bool refining = false;
+    bool unpublished = false;
+    bool shaded = false;
+    bool viewReady = false;
+    // Size of iterMap and the reuse state
+    int width = DISPLAY_WIDTH;
+    int height = DISPLAY_HEIGHT;
+
+    // View of the current frame. The zoom target is kept while zoomed past CENTERED_ZOOM,
+    // with the c it was found for, see prepareView().
+    JuliaView view;
+    JuliaReference reference;
+    bool hasTarget = false;
+    float targetCReal = 0.f;
+    float targetCImag = 0.f;
+    double targetX = 0.0;
+    double targetY = 0.0;
+
+    // Set by the worker when back holds a finished frame, cleared by the UI once swapped
+    std::atomic<bool> frameReady{false};
+    JuliaFrame buffers[2];
+    JuliaFrame* front;
+    JuliaFrame* back;
+    uint32_t generation = 0;
+    // Per row of the back buffer: the pixels that differ from the front buffer, as a
+    // half-open range, empty if none. Written by whichever worker shades the row.
+    struct RowSpan {
+        int16_t begin, end;
+    };
+    std::vector<RowSpan> dirtyRows;
+
+    // Iteration counts, the height buffer for the 3D effect. ITER is at most 256, so 16 bits hold any count.
+    std::vector<uint16_t> iterMap;
+
+    // Temporal reuse: whether iterMap holds a full-resolution frame of reuseParams, how many
+    // frames have reused it since it was computed from scratch, and whether the current one does
+    bool reuseValid = false;
+    JuliaParams reuseParams;
+    int reuseFrames = 0;
+    bool reusing = false;
+    // Sum of iterMap, the naive iteration count of the kept frame
+    uint64_t reuseNaiveIterations = 0;
+
+    // A pixel to re-iterate and its count in the kept frame
+    struct ReusePoint {
+        int32_t index;
+        int32_t previous;
+    };
+    // Per pixel: whether this frame has queued it
+    std::vector<uint8_t> reuseMarked;
+    // Per tile: pixels queued for the next round
+    std::vector<std::vector<ReusePoint>> reuseQueues;
+    // Pixels re-iterated in the last round
+    std::vector<ReusePoint> reuseRound;
+
+    PaletteLut palette;
+    ShadingLut shading;
+
+    // Iteration counts of the frame being refined, summed over its levels
+    std::atomic<uint64_t> frameIterations{0};
+    std::atomic<uint64_t> frameNaiveIterations{0};
+    std::atomic<uint64_t> lastIterations{0};
+    std::atomic<uint64_t> lastNaiveIterations{0};
+
+    // Worker time spent on the frame being refined, and whether one is in progress
+    uint64_t frameNs = 0;
+    bool frameOpen = false;
+    std::atomic<uint64_t> lastFrameNs{0};
+    std::atomic<bool> lastFrameComplete{false};
+    std::atomic<uint32_t> framesEnded{0};
+    std::atomic<uint32_t> framesCompleted{0};
+    std::atomic<uint32_t> requestsDropped{0};
+    // Worker, scheduler lock held
+    PerfHistogram frameTimes{FRAME_TIME_WINDOW};
+};
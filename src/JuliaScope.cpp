@@ -1,10 +1,27 @@
 #include "plugin.hpp"
+#include "JuliaRender.hpp"
+#include "TripleBuffer.hpp"
+#include "PitchTracker.hpp"
+#include "ScopeTrace.hpp"
+#include "PerfCounters.hpp"
+#include "SpscQueue.hpp"
+#include "FrameRecorder.hpp"
+#include <osdialog.h>
 #include <cmath>
 #include <algorithm>
+#include <memory>
+#include <thread>
+#include <atomic>
 
-static const int RING_BUFFER_SIZE = 2048;
-static const int DISPLAY_WIDTH = 200;
-static const int DISPLAY_HEIGHT = 155;
+// The pitch tracker analyzes the whole left ring buffer
+static const int RING_BUFFER_SIZE = PitchTracker::FRAME_SIZE;
+
+// Fixed recording frame rates in the context menu; 0 records the frames the display shows
+static const float RECORD_RATES[] = {0.f, 24.f, 30.f, 60.f};
+static const int RECORD_RATES_LEN = sizeof(RECORD_RATES) / sizeof(RECORD_RATES[0]);
+// Render time budgets per frame in the context menu, in ms; 0 is unlimited
+static const float FRAME_BUDGETS[] = {0.f, 2.f, 4.f, 8.f, 16.f};
+static const int FRAME_BUDGETS_LEN = sizeof(FRAME_BUDGETS) / sizeof(FRAME_BUDGETS[0]);
 
 struct JuliaScope : Module {
     enum ParamId {
@@ -32,39 +49,110 @@ struct JuliaScope : Module {
     enum LightId {
         LIGHTS_LEN
     };
+    enum Overlay {
+        OVERLAY_OFF,
+        OVERLAY_WAVEFORM,
+        OVERLAY_LISSAJOUS,
+        OVERLAYS_LEN
+    };
 
-    // Ring buffer for audio samples
+    // Ring buffer of left samples for the pitch tracker
     float leftBuffer[RING_BUFFER_SIZE] = {};
-    float rightBuffer[RING_BUFFER_SIZE] = {};
     int bufferIndex = 0;
 
+    // Min/max pyramid of both channels for the display overlay
+    ScopeTrace scopeTrace;
+
     // Envelope followers
     float leftEnvelope = 0.f;
     float rightEnvelope = 0.f;
 
-    // Pitch detection
-    float lastSample = 0.f;
-    int zeroCrossings = 0;
-    int samplesSinceReset = 0;
+    // Pitch detection, on the pitch tracker's thread; the last voiced estimate is held
+    // through silence and noise
+    PitchTracker pitchTracker;
+    dsp::ClockDivider pitchDivider;
     float detectedFreq = 440.f;
     float smoothFreq = 440.f;
-    static const int FREQ_WINDOW = 2048;
+    // detectedFreq on a log scale, 0 to 1, updated with it
+    float freqNorm = 0.5f;
+
+    // Zoom CV is exponential; 10V zooms in 40 octaves
+    static constexpr float ZOOM_OCTAVES_PER_VOLT = 4.f;
 
     // Smoothed modulation values
     float smoothCReal = -0.7f;
     float smoothCImag = 0.27015f;
+    // Zoom is smoothed in octaves, so deep zooms glide at a steady rate
+    float smoothZoomOctaves = 0.f;
     float smoothZoom = 1.f;
     float smoothTilt = 0.f;
 
     // Frame counter for display update
     int frameCounter = 0;
 
-    // Pixel buffer for fractal (RGBA)
-    uint8_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT * 4];
-    bool pixelsDirty = true;
+    // Control rate: parameters, CV and smoothing run once per CONTROL_BLOCK samples;
+    // only the ring buffer and the envelope followers run every sample
+    static const int CONTROL_BLOCK = 32;
+    dsp::ClockDivider controlDivider;
+    float leftEnvelopeSum = 0.f;
+    float rightEnvelopeSum = 0.f;
+
+    // Coefficients cached for coeffSpeed and coeffSampleTime
+    float coeffSpeed = -1.f;
+    float coeffSampleTime = 0.f;
+    float attackCoeff = 0.f;
+    float releaseCoeff = 0.f;
+    float smoothCoeff = 0.f;
+
+    // Everything the display renders, published as one snapshot per control block.
+    // Read only by JuliaScopeDisplay on the UI thread.
+    TripleBuffer<JuliaParams> renderState;
+
+    // Display settings, changed from the context menu
+    JuliaRenderOptions renderOptions;
+    // Render time per frame the display aims for, in ms; 0 keeps the best quality
+    float frameBudget = 4.f;
+    // Render at the display's size in screen pixels, up to MAX_DISPLAY_SCALE times the standard size
+    bool screenResolution = false;
+    // Signal drawn over the fractal
+    int overlay = OVERLAY_OFF;
+
+    // Recording settings: frames per second of audio (0 records what the display shows),
+    // FrameFormat, and frame size for fixed rates as a multiple of the standard size
+    float recordRate = 0.f;
+    int recordFormat = FRAME_FORMAT_PPM;
+    int recordScale = 1;
+
+    // While a recording runs, the audio thread keeps its clock, and at a fixed rate it
+    // queues the snapshot for every frame as its time comes. A new recordSession restarts
+    // the clock and the frame count.
+    struct RecordRequest {
+        JuliaParams params;
+        uint32_t frame = 0;
+    };
+    // About 4 s at 60 fps
+    static const int RECORD_QUEUE_SIZE = 256;
+    SpscQueue<RecordRequest, RECORD_QUEUE_SIZE> recordQueue;
+    std::atomic<bool> recordActive{false};
+    std::atomic<uint32_t> recordSession{0};
+    std::atomic<float> recordFps{0.f};
+    // Seconds of audio since the recording started, at the last control block
+    std::atomic<double> recordTime{0.0};
+    // Frames that were due while the queue was full
+    std::atomic<uint32_t> recordOverflows{0};
+    // Frames due so far in this recording, queued or not, so the sequencer can list the
+    // ones that never reached it
+    std::atomic<uint32_t> recordFramesDue{0};
+    // Audio thread recording state
+    uint32_t audioRecordSession = 0;
+    uint64_t recordSamples = 0;
+    uint32_t recordFrame = 0;
 
     float sampleRate = 44100.f;
 
+    // Cost of process(), measured on the audio thread
+    PerfSampler processTimes;
+
     JuliaScope() {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
         configParam(C_REAL_PARAM, -2.f, 2.f, -0.7f, "C Real");
@@ -80,13 +168,16 @@ struct JuliaScope : Module {
         configInput(RIGHT_INPUT, "Right Audio");
         configInput(RE_CV_INPUT, "C Real CV");
         configInput(IM_CV_INPUT, "C Imaginary CV");
-        configInput(ZOOM_CV_INPUT, "Zoom CV");
+        configInput(ZOOM_CV_INPUT, "Zoom CV, 4 octaves/V");
 
-        // Initialize pixel buffer to black
-        std::memset(pixels, 0, sizeof(pixels));
+        controlDivider.setDivision(CONTROL_BLOCK);
+        pitchDivider.setDivision(PitchTracker::HOP);
+        updateCoefficients(params[SPEED_PARAM].getValue(), 1.f / sampleRate);
+        publishRenderState();
     }
 
     void process(const ProcessArgs& args) override {
+        PerfScope timing(processTimes);
         sampleRate = args.sampleRate;
 
         // Get audio input (right normalizes to left)
@@ -96,33 +187,10 @@ struct JuliaScope : Module {
 
         // Store in ring buffer
         leftBuffer[bufferIndex] = leftSample;
-        rightBuffer[bufferIndex] = rightSample;
         bufferIndex = (bufferIndex + 1) % RING_BUFFER_SIZE;
-
-        // Zero-crossing pitch detection
-        if ((lastSample <= 0.f && leftSample > 0.f) || (lastSample >= 0.f && leftSample < 0.f)) {
-            zeroCrossings++;
-        }
-        lastSample = leftSample;
-        samplesSinceReset++;
-
-        if (samplesSinceReset >= FREQ_WINDOW) {
-            // Calculate frequency from zero crossings
-            // Each cycle has 2 zero crossings
-            float freq = (zeroCrossings / 2.f) * (args.sampleRate / (float)FREQ_WINDOW);
-            freq = clamp(freq, 20.f, 5000.f);
-            detectedFreq = freq;
-            zeroCrossings = 0;
-            samplesSinceReset = 0;
-        }
+        scopeTrace.push(leftSample, rightSample, args.sampleRate);
 
         // Envelope follower with adjustable speed
-        float speed = params[SPEED_PARAM].getValue();
-        float attackTime = 0.001f + (1.f - speed) * 0.1f;
-        float releaseTime = 0.01f + (1.f - speed) * 0.5f;
-        float attackCoeff = 1.f - std::exp(-args.sampleTime / attackTime);
-        float releaseCoeff = 1.f - std::exp(-args.sampleTime / releaseTime);
-
         float leftAbs = std::abs(leftSample);
         float rightAbs = std::abs(rightSample);
 
@@ -136,6 +204,56 @@ struct JuliaScope : Module {
         else
             rightEnvelope += releaseCoeff * (rightAbs - rightEnvelope);
 
+        leftEnvelopeSum += leftEnvelope;
+        rightEnvelopeSum += rightEnvelope;
+
+        if (controlDivider.process())
+            processControl(args.sampleTime);
+
+        // Hand the newest samples to the pitch tracker, after this sample's poll, so an
+        // estimate always arrives on a later sample however quickly a worker picks it up.
+        // Without a left input there is no pitch to track, and the last one is held.
+        if (pitchDivider.process() && inputs[LEFT_INPUT].isConnected())
+            pitchTracker.push(leftBuffer, bufferIndex, args.sampleRate);
+    }
+
+    // Recompute the envelope and smoothing coefficients, only when SPEED or the sample rate changed
+    void updateCoefficients(float speed, float sampleTime) {
+        if (speed == coeffSpeed && sampleTime == coeffSampleTime)
+            return;
+        coeffSpeed = speed;
+        coeffSampleTime = sampleTime;
+
+        float attackTime = 0.001f + (1.f - speed) * 0.1f;
+        float releaseTime = 0.01f + (1.f - speed) * 0.5f;
+        float smoothTime = 0.01f + (1.f - speed) * 0.1f;
+        attackCoeff = 1.f - std::exp(-sampleTime / attackTime);
+        releaseCoeff = 1.f - std::exp(-sampleTime / releaseTime);
+        // One step of this is CONTROL_BLOCK steps of the per-sample smoother
+        smoothCoeff = 1.f - std::exp(-sampleTime * CONTROL_BLOCK / smoothTime);
+    }
+
+    // Parameters, CV and smoothing, once per CONTROL_BLOCK samples
+    void processControl(float sampleTime) {
+        updateCoefficients(params[SPEED_PARAM].getValue(), sampleTime);
+
+        // Modulate by the block's average envelope, the same as averaging the
+        // per-sample targets the smoother would have seen
+        float leftMean = leftEnvelopeSum / CONTROL_BLOCK;
+        float rightMean = rightEnvelopeSum / CONTROL_BLOCK;
+        leftEnvelopeSum = 0.f;
+        rightEnvelopeSum = 0.f;
+
+        PitchEstimate estimate;
+        if (pitchTracker.poll(estimate) && estimate.voiced) {
+            detectedFreq = estimate.freq;
+
+            // Map frequency to tilt amount (0 to 1)
+            // Log scale: 20Hz -> 0, ~450Hz -> 0.5, 5000Hz -> 1
+            freqNorm = (std::log(detectedFreq) - std::log(20.f)) / (std::log(5000.f) - std::log(20.f));
+            freqNorm = clamp(freqNorm, 0.f, 1.f);
+        }
+
         // Get base parameters
         float baseCReal = params[C_REAL_PARAM].getValue();
         float baseCImag = params[C_IMAG_PARAM].getValue();
@@ -144,233 +262,504 @@ struct JuliaScope : Module {
         // Add CV modulation
         baseCReal += inputs[RE_CV_INPUT].getVoltage() * 0.2f;
         baseCImag += inputs[IM_CV_INPUT].getVoltage() * 0.2f;
-        baseZoom += inputs[ZOOM_CV_INPUT].getVoltage() * 0.1f;
-        baseZoom = clamp(baseZoom, 0.1f, 10.f);
-
-        // Add audio modulation
-        float modDepth = params[MOD_PARAM].getValue();
-        float targetCReal = baseCReal + leftEnvelope * modDepth * 0.5f;
-        float targetCImag = baseCImag + rightEnvelope * modDepth * 0.5f;
-
-        // Map frequency to tilt angle (-1 to 1)
-        // Log scale: 20Hz -> -1, ~450Hz -> 0, 5000Hz -> 1
-        float freqNorm = (std::log(detectedFreq) - std::log(20.f)) / (std::log(5000.f) - std::log(20.f));
-        freqNorm = clamp(freqNorm, 0.f, 1.f);
+        // Exponential, so 10V reaches the deepest zoom the renderer resolves
+        baseZoom *= std::exp2(inputs[ZOOM_CV_INPUT].getVoltage() * ZOOM_OCTAVES_PER_VOLT);
+        baseZoom = clamp(baseZoom, 0.1f, JuliaView::MAX_ZOOM);
+
+        // Add audio modulation, scaled down with the view when zoomed in past the whole set
+        float modDepth = params[MOD_PARAM].getValue() * std::min(1.f, JuliaView::CENTERED_ZOOM / smoothZoom);
+        float targetCReal = baseCReal + leftMean * modDepth * 0.5f;
+        float targetCImag = baseCImag + rightMean * modDepth * 0.5f;
+
+        // Tilt angle (-1 to 1) from the detected frequency
         float tiltAmount = params[TILT_PARAM].getValue();
         float targetTilt = (freqNorm * 2.f - 1.f) * tiltAmount;
 
         // Smooth the values
-        float smoothCoeff = 1.f - std::exp(-args.sampleTime / (0.01f + (1.f - speed) * 0.1f));
         smoothCReal += smoothCoeff * (targetCReal - smoothCReal);
         smoothCImag += smoothCoeff * (targetCImag - smoothCImag);
-        smoothZoom += smoothCoeff * (baseZoom - smoothZoom);
+        smoothZoomOctaves += smoothCoeff * (std::log2(baseZoom) - smoothZoomOctaves);
+        smoothZoom = std::exp2(smoothZoomOctaves);
         smoothTilt += smoothCoeff * (targetTilt - smoothTilt);
         smoothFreq += smoothCoeff * (detectedFreq - smoothFreq);
 
-        // Mark pixels dirty (actual rendering happens in widget)
-        pixelsDirty = true;
+        publishRenderState();
     }
 
-    float getCReal() { return smoothCReal; }
-    float getCImag() { return smoothCImag; }
-    float getZoom() { return smoothZoom; }
-    float getTilt() { return smoothTilt; }
-    float getFreq() { return smoothFreq; }
-    int getMaxIter() { return (int)params[ITER_PARAM].getValue(); }
-    int getColorMode() { return (int)params[COLOR_PARAM].getValue(); }
-};
+    void publishRenderState() {
+        JuliaParams& p = renderState.write();
+        p.cReal = smoothCReal;
+        p.cImag = smoothCImag;
+        p.zoom = smoothZoom;
+        p.tilt = smoothTilt;
+        p.maxIter = (int)params[ITER_PARAM].getValue();
+        p.colorMode = (int)params[COLOR_PARAM].getValue();
+        if (recordActive.load(std::memory_order_acquire))
+            queueRecordFrames(p);
+        renderState.publish();
+    }
+
+    // Audio thread, once per control block while recording: advance the recording clock
+    // and, at a fixed rate, queue the block's snapshot for every frame due by its end
+    void queueRecordFrames(const JuliaParams& p) {
+        uint32_t session = recordSession.load(std::memory_order_relaxed);
+        if (session != audioRecordSession) {
+            audioRecordSession = session;
+            recordSamples = 0;
+            recordFrame = 0;
+        }
+        recordSamples += CONTROL_BLOCK;
+        recordTime.store(recordSamples / (double)sampleRate, std::memory_order_relaxed);
 
-// Color palette functions
-struct ColorPalette {
-    static void getColor(int mode, int iter, int maxIter, float brightness, uint8_t& r, uint8_t& g, uint8_t& b) {
-        if (iter >= maxIter) {
-            r = g = b = 0;
+        double fps = recordFps.load(std::memory_order_relaxed);
+        if (fps <= 0.0)
             return;
+        // Frame k is due at k / fps seconds. Compared in samples, which is exact for whole
+        // frame and sample rates, so a frame on a block boundary is never missed.
+        while (recordFrame * (double)sampleRate <= recordSamples * fps) {
+            RecordRequest request;
+            request.params = p;
+            request.frame = recordFrame++;
+            if (!recordQueue.push(request))
+                recordOverflows.fetch_add(1, std::memory_order_relaxed);
         }
+        recordFramesDue.store(recordFrame, std::memory_order_release);
+    }
 
-        float t = (float)iter / (float)maxIter;
-
-        float br = 0.f, bg = 0.f, bb = 0.f;
-
-        switch (mode) {
-            case 0: // Classic blue-white
-                br = 9 * (1 - t) * t * t * t;
-                bg = 15 * (1 - t) * (1 - t) * t * t;
-                bb = 8.5f * (1 - t) * (1 - t) * (1 - t) * t;
-                break;
-            case 1: // Fire
-                br = std::min(1.f, t * 3.f);
-                bg = std::max(0.f, std::min(1.f, t * 3.f - 1.f));
-                bb = std::max(0.f, t * 3.f - 2.f);
-                break;
-            case 2: // Ocean
-                br = t * t;
-                bg = t;
-                bb = std::sqrt(t);
-                break;
-            case 3: // Rainbow
-                {
-                    float h = t * 6.f;
-                    int i = (int)h;
-                    float f = h - i;
-                    switch (i % 6) {
-                        case 0: br = 1.f; bg = f; bb = 0.f; break;
-                        case 1: br = 1.f - f; bg = 1.f; bb = 0.f; break;
-                        case 2: br = 0.f; bg = 1.f; bb = f; break;
-                        case 3: br = 0.f; bg = 1.f - f; bb = 1.f; break;
-                        case 4: br = f; bg = 0.f; bb = 1.f; break;
-                        case 5: br = 1.f; bg = 0.f; bb = 1.f - f; break;
-                    }
-                }
-                break;
-            case 4: // Grayscale
-            default:
-                br = bg = bb = t;
-                break;
+    json_t* dataToJson() override {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "progressive", json_boolean(renderOptions.progressive));
+        json_object_set_new(rootJ, "periodicity", json_boolean(renderOptions.periodicity));
+        json_object_set_new(rootJ, "boundaryTrace", json_boolean(renderOptions.boundaryTrace));
+        json_object_set_new(rootJ, "temporalReuse", json_boolean(renderOptions.temporalReuse));
+        json_object_set_new(rootJ, "frameBudget", json_real(frameBudget));
+        json_object_set_new(rootJ, "overlay", json_integer(overlay));
+        json_object_set_new(rootJ, "screenResolution", json_boolean(screenResolution));
+        json_object_set_new(rootJ, "recordRate", json_real(recordRate));
+        json_object_set_new(rootJ, "recordFormat", json_integer(recordFormat));
+        json_object_set_new(rootJ, "recordScale", json_integer(recordScale));
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override {
+        json_t* progressiveJ = json_object_get(rootJ, "progressive");
+        if (progressiveJ)
+            renderOptions.progressive = json_boolean_value(progressiveJ);
+        json_t* periodicityJ = json_object_get(rootJ, "periodicity");
+        if (periodicityJ)
+            renderOptions.periodicity = json_boolean_value(periodicityJ);
+        json_t* boundaryTraceJ = json_object_get(rootJ, "boundaryTrace");
+        if (boundaryTraceJ)
+            renderOptions.boundaryTrace = json_boolean_value(boundaryTraceJ);
+        json_t* temporalReuseJ = json_object_get(rootJ, "temporalReuse");
+        if (temporalReuseJ)
+            renderOptions.temporalReuse = json_boolean_value(temporalReuseJ);
+        json_t* frameBudgetJ = json_object_get(rootJ, "frameBudget");
+        if (frameBudgetJ)
+            frameBudget = clamp((float)json_number_value(frameBudgetJ), 0.f, FRAME_BUDGETS[FRAME_BUDGETS_LEN - 1]);
+        json_t* overlayJ = json_object_get(rootJ, "overlay");
+        if (overlayJ)
+            overlay = clamp((int)json_integer_value(overlayJ), 0, OVERLAYS_LEN - 1);
+        json_t* screenResolutionJ = json_object_get(rootJ, "screenResolution");
+        if (screenResolutionJ)
+            screenResolution = json_boolean_value(screenResolutionJ);
+        json_t* recordRateJ = json_object_get(rootJ, "recordRate");
+        if (recordRateJ) {
+            // Snapped to the nearest rate the menu offers, since the sequencer and the
+            // audio thread's frame clock take it as it is
+            float rate = json_number_value(recordRateJ);
+            recordRate = RECORD_RATES[0];
+            for (int i = 1; i < RECORD_RATES_LEN; i++) {
+                if (std::abs(rate - RECORD_RATES[i]) < std::abs(rate - recordRate))
+                    recordRate = RECORD_RATES[i];
+            }
         }
+        json_t* recordFormatJ = json_object_get(rootJ, "recordFormat");
+        if (recordFormatJ)
+            recordFormat = clamp((int)json_integer_value(recordFormatJ), 0, FRAME_FORMATS_LEN - 1);
+        json_t* recordScaleJ = json_object_get(rootJ, "recordScale");
+        if (recordScaleJ)
+            recordScale = clamp((int)json_integer_value(recordScaleJ), 1, MAX_DISPLAY_SCALE);
+    }
+};
 
-        // Apply brightness (3D lighting)
-        br *= brightness;
-        bg *= brightness;
-        bb *= brightness;
+// Renders a fixed rate recording on a thread of its own: every snapshot the audio thread
+// queues, at full quality and to completion, with its own JuliaRenderer on the shared
+// workers. The frames only depend on the audio, not on the UI refresh rate, the frame
+// budget or whether the scope is on screen. It waits for pool buffers rather than
+// dropping frames, so a slow disk delays the recording instead of leaving gaps.
+//
+// Frames it can't render are listed in the index as skipped: those the audio thread
+// couldn't queue because rendering fell RECORD_QUEUE_SIZE frames behind, and at stop the
+// ones still queued or never queued. Stopping only waits for the frame being rendered, so
+// closing a patch mid-recording never waits for seconds of rendering.
+struct JuliaSequenceRenderer {
+    // How often the thread looks for a queued snapshot or a finished frame
+    static const int POLL_US = 250;
+
+    JuliaSequenceRenderer(JuliaScope* module, FrameRecorder& recorder, float fps, const JuliaRenderOptions& options)
+        : module(module), recorder(recorder), fps(fps), options(options) {
+        // Nothing left over from an earlier recording
+        module->recordQueue.clear();
+        thread = std::thread([this]() { run(); });
+    }
 
-        r = (uint8_t)(clamp(br, 0.f, 1.f) * 255);
-        g = (uint8_t)(clamp(bg, 0.f, 1.f) * 255);
-        b = (uint8_t)(clamp(bb, 0.f, 1.f) * 255);
+    // Finishes the frame being rendered, skips the ones still queued, then stops
+    ~JuliaSequenceRenderer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_one();
+        thread.join();
     }
+
+private:
+    void run() {
+        system::setThreadName("JuliaScope sequence");
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            JuliaScope::RecordRequest request;
+            if (stopping) {
+                while (module->recordQueue.pop(request))
+                    skipTo(request.frame + 1);
+                skipTo(module->recordFramesDue.load(std::memory_order_acquire));
+                return;
+            }
+            if (!module->recordQueue.pop(request)) {
+                cv.wait_for(lock, std::chrono::microseconds(POLL_US), [this]() { return stopping; });
+                continue;
+            }
+            // Frames are queued in order, so a gap is frames that overflowed the queue
+            skipTo(request.frame);
+            nextFrame = request.frame + 1;
+
+            lock.unlock();
+            renderer.request(request.params, options);
+            // Not progressive, so the first frame published is the finished one
+            while (!renderer.acquireFrame())
+                std::this_thread::sleep_for(std::chrono::microseconds(POLL_US));
+            const JuliaFrame& frame = renderer.getFrame();
+            recorder.submit(frame.pixels.data(), frame.width, frame.height, request.frame, request.frame / (double)fps, true);
+            lock.lock();
+        }
+    }
+
+    // Lists every frame from nextFrame up to end as skipped
+    void skipTo(uint32_t end) {
+        for (; nextFrame < end; nextFrame++)
+            recorder.skip(nextFrame, nextFrame / (double)fps);
+    }
+
+    JuliaScope* module;
+    FrameRecorder& recorder;
+    float fps;
+    // The first frame not yet rendered or skipped
+    uint32_t nextFrame = 0;
+    JuliaRenderOptions options;
+    JuliaRenderer renderer;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
 };
 
+// Uploads the rectangle (x, y, w, h) of an RGBA image imageWidth pixels wide. NanoVG
+// only updates whole images, so this goes to the image's GL texture directly, and
+// leaves the texture binding and unpack state as NanoVG expects them.
+static void updateImageRect(NVGcontext* vg, int image, int imageWidth, int x, int y, int w, int h, const uint8_t* data) {
+    GLint bound = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+    glBindTexture(GL_TEXTURE_2D, nvglImageHandleGL2(vg, image));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, imageWidth);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glBindTexture(GL_TEXTURE_2D, bound);
+}
+
 struct JuliaScopeDisplay : TransparentWidget {
+    // Screen resolution frame widths are multiples of this, which keeps the aspect ratio exact
+    static const int FRAME_WIDTH_STEP = 40;
+
     JuliaScope* module = nullptr;
     int nvgImage = -1;
     int frameSkip = 0;
-    static const int FRAME_SKIP_COUNT = 2;
-
-    uint8_t localPixels[DISPLAY_WIDTH * DISPLAY_HEIGHT * 4];
-
-    // Height buffer for 3D effect
-    float heightMap[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+    // UI frames the governor's frame skip didn't request a render for
+    uint32_t framesThrottled = 0;
+
+    // Size and generation of the frame in nvgImage
+    int imageWidth = 0;
+    int imageHeight = 0;
+    uint32_t imageGeneration = 0;
+    // Frame size to request
+    int frameWidth = DISPLAY_WIDTH;
+    int frameHeight = DISPLAY_HEIGHT;
+
+    // Texture traffic: UI frames drawn, uploads and the bytes they sent
+    uint32_t uiFrames = 0;
+    uint32_t uploads = 0;
+    uint64_t uploadedBytes = 0;
+
+    // Frame sequence recording. Without a sequencer, the frames the display shows are
+    // recorded, numbered in the order they appear and stamped with the audio time of the
+    // request they answer.
+    FrameRecorder recorder;
+    std::unique_ptr<JuliaSequenceRenderer> sequencer;
+    uint32_t liveFrames = 0;
+    double requestTime = 0.0;
+
+    // Picks the resolution, iteration cap and frame skip from the measured render time
+    JuliaGovernor governor;
+
+    // Created on first draw, so module browser previews don't start the render workers
+    std::unique_ptr<JuliaRenderer> renderer;
+
+    // Parameters of the last requested frame
+    JuliaFrameKey lastKey;
+    JuliaRenderOptions lastOptions;
+    bool hasLastKey = false;
+
+    bool optionsChanged(const JuliaRenderOptions& o) {
+        // Progressive refinement doesn't change the finished frame
+        return o.periodicity != lastOptions.periodicity || o.boundaryTrace != lastOptions.boundaryTrace
+            || o.resolutionStep != lastOptions.resolutionStep || o.width != lastOptions.width || o.height != lastOptions.height;
+    }
 
     JuliaScopeDisplay() {
         box.size = mm2px(Vec(70.f, 54.f));
-        std::memset(localPixels, 0, sizeof(localPixels));
-        std::memset(heightMap, 0, sizeof(heightMap));
     }
 
     ~JuliaScopeDisplay() {
-        // Image cleanup handled by NanoVG context
-    }
-
-    void renderJuliaSet() {
-        if (!module) return;
-
-        float cReal = module->getCReal();
-        float cImag = module->getCImag();
-        float zoom = module->getZoom();
-        float tilt = module->getTilt();
-        int maxIter = module->getMaxIter();
-        int colorMode = module->getColorMode();
-
-        float aspectRatio = (float)DISPLAY_WIDTH / (float)DISPLAY_HEIGHT;
-        float xMin = -2.f / zoom * aspectRatio;
-        float xMax = 2.f / zoom * aspectRatio;
-        float yMin = -2.f / zoom;
-        float yMax = 2.f / zoom;
-
-        // Tilt creates a perspective transformation
-        // tilt = -1: looking from bottom, tilt = 1: looking from top
-        float tiltAngle = tilt * 0.5f; // radians
-
-        // First pass: compute iteration counts (height map)
-        for (int py = 0; py < DISPLAY_HEIGHT; py++) {
-            for (int px = 0; px < DISPLAY_WIDTH; px++) {
-                // Apply perspective based on tilt
-                float normY = (float)py / (float)DISPLAY_HEIGHT;
-                float perspectiveScale = 1.f + tiltAngle * (normY - 0.5f) * 0.5f;
-
-                float x0 = xMin + (xMax - xMin) * px / (float)DISPLAY_WIDTH;
-                float y0 = yMin + (yMax - yMin) * py / (float)DISPLAY_HEIGHT;
-
-                // Apply perspective to y
-                y0 *= perspectiveScale;
-
-                float x = x0;
-                float y = y0;
-                int iter = 0;
-
-                while (x * x + y * y <= 4.f && iter < maxIter) {
-                    float xTemp = x * x - y * y + cReal;
-                    y = 2.f * x * y + cImag;
-                    x = xTemp;
-                    iter++;
-                }
+        // Image cleanup handled by NanoVG context; the renderer detaches from the scheduler
+        // here, waiting for any worker still on it, before the module widget deletes the module
+        stopRecording();
+    }
 
-                heightMap[py * DISPLAY_WIDTH + px] = (float)iter / (float)maxIter;
-            }
+    // UI thread: record into directory with the module's recording settings
+    bool startRecording(const std::string& directory, std::string& error) {
+        stopRecording();
+        if (!recorder.start(directory, (FrameFormat)module->recordFormat, MAX_DISPLAY_WIDTH, MAX_DISPLAY_HEIGHT, error))
+            return false;
+
+        liveFrames = 0;
+        module->recordOverflows.store(0, std::memory_order_relaxed);
+        module->recordFramesDue.store(0, std::memory_order_relaxed);
+        module->recordFps.store(module->recordRate, std::memory_order_relaxed);
+        module->recordSession.fetch_add(1, std::memory_order_relaxed);
+        if (module->recordRate > 0.f) {
+            JuliaRenderOptions o = module->renderOptions;
+            o.progressive = false;
+            o.temporalReuse = false;
+            o.resolutionStep = 1;
+            o.width = DISPLAY_WIDTH * module->recordScale;
+            o.height = DISPLAY_HEIGHT * module->recordScale;
+            sequencer.reset(new JuliaSequenceRenderer(module, recorder, module->recordRate, o));
         }
+        module->recordActive.store(true, std::memory_order_release);
+        return true;
+    }
 
-        // Second pass: compute normals and apply lighting
-        float lightDir[3] = {-0.3f - tilt * 0.5f, -0.5f, 1.f};
-        float lightLen = std::sqrt(lightDir[0]*lightDir[0] + lightDir[1]*lightDir[1] + lightDir[2]*lightDir[2]);
-        lightDir[0] /= lightLen;
-        lightDir[1] /= lightLen;
-        lightDir[2] /= lightLen;
-
-        for (int py = 0; py < DISPLAY_HEIGHT; py++) {
-            for (int px = 0; px < DISPLAY_WIDTH; px++) {
-                float h = heightMap[py * DISPLAY_WIDTH + px];
-                int iter = (int)(h * maxIter);
-
-                // Compute normal from height map gradient
-                float hL = px > 0 ? heightMap[py * DISPLAY_WIDTH + (px-1)] : h;
-                float hR = px < DISPLAY_WIDTH-1 ? heightMap[py * DISPLAY_WIDTH + (px+1)] : h;
-                float hU = py > 0 ? heightMap[(py-1) * DISPLAY_WIDTH + px] : h;
-                float hD = py < DISPLAY_HEIGHT-1 ? heightMap[(py+1) * DISPLAY_WIDTH + px] : h;
-
-                float nx = (hL - hR) * 2.f;
-                float ny = (hU - hD) * 2.f;
-                float nz = 0.1f;
-                float nLen = std::sqrt(nx*nx + ny*ny + nz*nz);
-                nx /= nLen; ny /= nLen; nz /= nLen;
-
-                // Diffuse lighting
-                float diffuse = std::max(0.f, nx * lightDir[0] + ny * lightDir[1] + nz * lightDir[2]);
-
-                // Ambient + diffuse
-                float brightness = 0.3f + 0.7f * diffuse;
-
-                // Add specular highlight for high iteration areas
-                if (h > 0.5f) {
-                    float spec = std::pow(diffuse, 8.f) * 0.5f;
-                    brightness += spec;
-                }
+    // UI thread: finish the frame being rendered and close the recording. Waits for at most
+    // one fixed rate frame and the writes already queued.
+    void stopRecording() {
+        if (!recorder.isRecording())
+            return;
+        module->recordActive.store(false, std::memory_order_release);
+        sequencer.reset();
+        recorder.stop();
+    }
 
-                int idx = (py * DISPLAY_WIDTH + px) * 4;
-                uint8_t r = 0, g = 0, b = 0;
-                ColorPalette::getColor(colorMode, iter, maxIter, brightness, r, g, b);
-                localPixels[idx + 0] = r;
-                localPixels[idx + 1] = g;
-                localPixels[idx + 2] = b;
-                localPixels[idx + 3] = 255;
-            }
+    void requestFrame() {
+        // A consistent snapshot from a single control block, never a mix of samples
+        module->renderState.update();
+        JuliaParams p = module->renderState.read();
+        JuliaRenderOptions o = module->renderOptions;
+        o.width = frameWidth;
+        o.height = frameHeight;
+        governor.apply(p, o);
+
+        // Nothing visible has changed, so the current frame is still valid
+        JuliaFrameKey key = p.key();
+        if (hasLastKey && key == lastKey && !optionsChanged(o))
+            return;
+        lastKey = key;
+        lastOptions = o;
+        hasLastKey = true;
+
+        requestTime = module->recordTime.load(std::memory_order_relaxed);
+        renderer->request(p, o);
+    }
+
+    JuliaRenderStats getStats() {
+        return renderer ? renderer->getStats() : JuliaRenderStats();
+    }
+
+    bool getFrameTimes(PerfSummary& summary) {
+        return renderer && renderer->getFrameTimes(summary);
+    }
+
+    // Frames never rendered: throttled by the governor, superseded before a worker started
+    // them, or abandoned for a newer request part way through
+    uint32_t getFramesSkipped(const JuliaRenderStats& stats) const {
+        return framesThrottled + stats.dropped + (stats.frames - stats.completed);
+    }
+
+    // Overlay spans; the waveform is drawn from the finest pyramid level with at most
+    // OVERLAY_BINS bins across it, so a frame costs a few hundred vertices per channel
+    static const int WAVEFORM_SAMPLES = 2048;
+    static const int LISSAJOUS_SAMPLES = 1024;
+    static const int OVERLAY_BINS = 256;
+
+    // Input voltage divided by 5 to display units, 1 reaching 45% of the display height
+    float traceY(float v) {
+        return box.size.y * (0.5f - 0.45f * clamp(v, -1.1f, 1.1f));
+    }
+
+    // Min/max envelope of one channel, as a band from its maxima forward and its minima back
+    void drawWaveform(NVGcontext* vg, const ScopeTraceFrame& trace, bool right, NVGcolor color) {
+        int level = ScopeTraceFrame::levelFor(WAVEFORM_SAMPLES, OVERLAY_BINS);
+        int count = WAVEFORM_SAMPLES / (ScopeTraceFrame::BASE_SAMPLES << level);
+        uint32_t first = (trace.written >> level) - count;
+        float dx = box.size.x / (count - 1);
+
+        nvgBeginPath(vg);
+        for (int i = 0; i < count; i++) {
+            const ScopeTraceBin& bin = trace.bin(level, first + i);
+            float y = traceY(right ? bin.maxRight : bin.maxLeft);
+            if (i == 0)
+                nvgMoveTo(vg, 0.f, y);
+            else
+                nvgLineTo(vg, i * dx, y);
+        }
+        for (int i = count - 1; i >= 0; i--) {
+            const ScopeTraceBin& bin = trace.bin(level, first + i);
+            nvgLineTo(vg, i * dx, traceY(right ? bin.minRight : bin.minLeft));
         }
+        nvgFillColor(vg, nvgTransRGBA(color, 64));
+        nvgFill(vg);
+        nvgStrokeColor(vg, color);
+        nvgStrokeWidth(vg, 1.f);
+        nvgStroke(vg);
     }
 
-    void drawLayer(const DrawArgs& args, int layer) override {
-        if (layer != 1) return;
+    // Left against right, one point per level 0 bin at the middle of its range
+    void drawLissajous(NVGcontext* vg, const ScopeTraceFrame& trace, NVGcolor color) {
+        int count = LISSAJOUS_SAMPLES / ScopeTraceFrame::BASE_SAMPLES;
+        uint32_t first = trace.written - count;
+        float radius = 0.45f * std::min(box.size.x, box.size.y);
+
+        nvgBeginPath(vg);
+        for (int i = 0; i < count; i++) {
+            const ScopeTraceBin& bin = trace.bin(0, first + i);
+            float x = 0.5f * box.size.x + radius * clamp(0.5f * (bin.minLeft + bin.maxLeft), -1.1f, 1.1f);
+            float y = 0.5f * box.size.y - radius * clamp(0.5f * (bin.minRight + bin.maxRight), -1.1f, 1.1f);
+            if (i == 0)
+                nvgMoveTo(vg, x, y);
+            else
+                nvgLineTo(vg, x, y);
+        }
+        nvgStrokeColor(vg, color);
+        nvgStrokeWidth(vg, 1.f);
+        nvgStroke(vg);
+    }
+
+    void drawOverlay(NVGcontext* vg) {
+        // The latest pyramid the audio thread published; never blocks
+        const ScopeTraceFrame* trace = module->scopeTrace.acquire();
+        if (!trace)
+            return;
+        if (module->overlay == JuliaScope::OVERLAY_WAVEFORM) {
+            drawWaveform(vg, *trace, false, nvgRGBA(136, 136, 255, 220));
+            drawWaveform(vg, *trace, true, nvgRGBA(153, 255, 153, 220));
+        } else if (module->overlay == JuliaScope::OVERLAY_LISSAJOUS) {
+            drawLissajous(vg, *trace, nvgRGBA(230, 230, 230, 220));
+        }
+    }
+
+    // The display's width in screen pixels, from the scale of the current transform, which
+    // includes the rack zoom and the window's pixel ratio
+    void updateFrameSize(NVGcontext* vg) {
+        int width = DISPLAY_WIDTH;
+        if (module->screenResolution) {
+            float transform[6];
+            nvgCurrentTransform(vg, transform);
+            float pixels = box.size.x * std::hypot(transform[0], transform[1]);
+            width = (int)std::lround(pixels / FRAME_WIDTH_STEP) * FRAME_WIDTH_STEP;
+            width = clamp(width, DISPLAY_WIDTH, MAX_DISPLAY_WIDTH);
+        }
+        frameWidth = width;
+        frameHeight = width * DISPLAY_HEIGHT / DISPLAY_WIDTH;
+    }
 
-        // Frame skip for performance
-        frameSkip++;
-        if (frameSkip >= FRAME_SKIP_COUNT) {
-            frameSkip = 0;
-            renderJuliaSet();
+    // Sends the texture only frames it doesn't have yet, and of those, only the rectangle
+    // that changed since the previous one
+    void updateImage(NVGcontext* vg) {
+        const JuliaFrame& frame = renderer->getFrame();
+        uiFrames++;
+        if (nvgImage != -1 && (frame.width != imageWidth || frame.height != imageHeight)) {
+            nvgDeleteImage(vg, nvgImage);
+            nvgImage = -1;
         }
 
-        // Create or update NanoVG image
         if (nvgImage == -1) {
-            nvgImage = nvgCreateImageRGBA(args.vg, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, localPixels);
+            nvgImage = nvgCreateImageRGBA(vg, frame.width, frame.height, 0, frame.pixels.data());
+            imageWidth = frame.width;
+            imageHeight = frame.height;
+        } else if (frame.generation == imageGeneration) {
+            return;
+        } else if (frame.generation == imageGeneration + 1 && frame.dirtyWidth * frame.dirtyHeight < frame.width * frame.height) {
+            imageGeneration = frame.generation;
+            if (frame.dirtyWidth == 0)
+                return;
+            updateImageRect(vg, nvgImage, frame.width, frame.dirtyX, frame.dirtyY, frame.dirtyWidth, frame.dirtyHeight,
+                frame.pixels.data());
+            uploads++;
+            uploadedBytes += frame.dirtyWidth * frame.dirtyHeight * 4;
+            return;
         } else {
-            nvgUpdateImage(args.vg, nvgImage, localPixels);
+            nvgUpdateImage(vg, nvgImage, frame.pixels.data());
+        }
+        imageGeneration = frame.generation;
+        uploads++;
+        uploadedBytes += frame.width * frame.height * 4;
+    }
+
+    void drawLayer(const DrawArgs& args, int layer) override {
+        if (layer != 1) return;
+
+        if (module) {
+            if (!renderer)
+                renderer.reset(new JuliaRenderer);
+
+            // Pick up whatever the workers finished since the last frame; never blocks.
+            // Recording as displayed skips the coarse progressive levels, which would
+            // otherwise show up as extra, blurrier copies of the same frame.
+            if (renderer->acquireFrame() && recorder.isRecording() && !sequencer) {
+                const JuliaFrame& frame = renderer->getFrame();
+                if (frame.finished)
+                    recorder.submit(frame.pixels.data(), frame.width, frame.height, liveFrames++, requestTime, false);
+            }
+            governor.budgetMs = module->frameBudget;
+            governor.update(renderer->getStats());
+
+            // Frame skip for performance
+            frameSkip++;
+            if (frameSkip >= governor.getQuality().frameSkip) {
+                frameSkip = 0;
+                requestFrame();
+            } else {
+                framesThrottled++;
+            }
+
+            updateImage(args.vg);
+            updateFrameSize(args.vg);
         }
 
         if (nvgImage != -1) {
@@ -381,6 +770,9 @@ struct JuliaScopeDisplay : TransparentWidget {
             nvgFill(args.vg);
         }
 
+        if (module && module->overlay != JuliaScope::OVERLAY_OFF)
+            drawOverlay(args.vg);
+
         // Draw border
         nvgBeginPath(args.vg);
         nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
@@ -404,6 +796,8 @@ struct JuliaScopeDisplay : TransparentWidget {
 };
 
 struct JuliaScopeWidget : ModuleWidget {
+    JuliaScopeDisplay* display;
+
     JuliaScopeWidget(JuliaScope* module) {
         setModule(module);
         setPanel(createPanel(asset::plugin(pluginInstance, "res/JuliaScope.svg")));
@@ -415,7 +809,7 @@ struct JuliaScopeWidget : ModuleWidget {
         addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
 
         // Display widget - centered at top
-        JuliaScopeDisplay* display = createWidget<JuliaScopeDisplay>(mm2px(Vec(5.64, 14)));
+        display = createWidget<JuliaScopeDisplay>(mm2px(Vec(5.64, 14)));
         display->module = module;
         addChild(display);
 
@@ -441,6 +835,139 @@ struct JuliaScopeWidget : ModuleWidget {
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(71.12, 117)), module, JuliaScope::ZOOM_CV_INPUT));
     }
 
+    void appendContextMenu(Menu* menu) override {
+        JuliaScope* module = getModule<JuliaScope>();
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createMenuLabel("Display"));
+        menu->addChild(createBoolPtrMenuItem("Progressive refinement", "", &module->renderOptions.progressive));
+        menu->addChild(createBoolPtrMenuItem("Interior detection", "", &module->renderOptions.periodicity));
+        menu->addChild(createBoolPtrMenuItem("Boundary tracing", "", &module->renderOptions.boundaryTrace));
+        menu->addChild(createBoolPtrMenuItem("Temporal reuse", "", &module->renderOptions.temporalReuse));
+        menu->addChild(createBoolPtrMenuItem("Render at screen resolution", "", &module->screenResolution));
+
+        menu->addChild(createIndexSubmenuItem("Frame budget", {"Unlimited", "2 ms", "4 ms", "8 ms", "16 ms"},
+            [=]() {
+                for (int i = 0; i < FRAME_BUDGETS_LEN; i++) {
+                    if (module->frameBudget == FRAME_BUDGETS[i])
+                        return (size_t)i;
+                }
+                return (size_t)0;
+            },
+            [=](size_t i) { module->frameBudget = FRAME_BUDGETS[i]; }));
+        menu->addChild(createIndexSubmenuItem("Overlay", {"Off", "Waveform", "Lissajous"},
+            [=]() { return (size_t)module->overlay; },
+            [=](size_t i) { module->overlay = (int)i; }));
+
+        const JuliaGovernor& governor = display->governor;
+        const JuliaQuality& quality = governor.getQuality();
+        std::string resolution = quality.resolutionStep > 1 ? string::f("1/%d", quality.resolutionStep) : "full";
+        menu->addChild(createMenuLabel(string::f("Quality: %d of %d, %s resolution, %.0f%% iterations, 1 frame in %d",
+            JuliaGovernor::LEVEL_COUNT - governor.getLevel(), JuliaGovernor::LEVEL_COUNT,
+            resolution.c_str(), quality.iterScale * 100.f, quality.frameSkip)));
+        if (module->frameBudget > 0.f)
+            menu->addChild(createMenuLabel(string::f("Render: %.2f of %.0f ms per frame", governor.getAverageMs(), module->frameBudget)));
+        else
+            menu->addChild(createMenuLabel(string::f("Render: %.2f ms per frame", governor.getAverageMs())));
+
+        JuliaRenderStats stats = display->getStats();
+        if (stats.naiveIterations > 0) {
+            float saved = 1.f - (float)stats.iterations / (float)stats.naiveIterations;
+            menu->addChild(createMenuLabel(string::f("Iterations: %.0fk/frame, %.0f%% saved",
+                stats.iterations / 1000.f, saved * 100.f)));
+        }
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createMenuLabel("Performance"));
+        PerfSummary process;
+        if (module->processTimes.histogram.read(process))
+            menu->addChild(createMenuLabel("Process: " + process.format() + " per sample"));
+        else
+            menu->addChild(createMenuLabel("Process: measuring"));
+        PerfSummary frameTimes;
+        if (display->getFrameTimes(frameTimes))
+            menu->addChild(createMenuLabel("Finished frames: " + frameTimes.format()));
+        menu->addChild(createMenuLabel(string::f("Frames: %u rendered, %u skipped",
+            stats.completed, display->getFramesSkipped(stats))));
+        if (display->uiFrames > 0) {
+            menu->addChild(createMenuLabel(string::f("Texture: %dx%d, %.0f%% of UI frames uploaded, %.1f KB each",
+                display->imageWidth, display->imageHeight, 100.f * display->uploads / display->uiFrames,
+                display->uploads > 0 ? display->uploadedBytes / 1024.f / display->uploads : 0.f)));
+        }
+        menu->addChild(createMenuItem("Save performance stats...", "", [=]() {
+            savePerfJson(perfToJson(), "JuliaScope-performance.json");
+        }));
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createMenuLabel("Recording"));
+        if (display->recorder.isRecording()) {
+            if (display->recorder.hasFailed()) {
+                menu->addChild(createMenuLabel("Cannot write to " + display->recorder.getDirectory()));
+            } else {
+                menu->addChild(createMenuLabel(string::f("%u frames, %.1f MB written, %u dropped",
+                    display->recorder.getWritten(), display->recorder.getBytes() / 1e6,
+                    display->recorder.getDropped() + module->recordOverflows.load(std::memory_order_relaxed))));
+            }
+            menu->addChild(createMenuItem("Stop recording", "", [=]() { display->stopRecording(); }));
+        } else {
+            menu->addChild(createMenuItem("Start recording...", "", [=]() { startRecordingDialog(); }));
+        }
+        menu->addChild(createIndexSubmenuItem("Frame rate", {"As displayed", "24 fps", "30 fps", "60 fps"},
+            [=]() {
+                for (int i = 0; i < RECORD_RATES_LEN; i++) {
+                    if (module->recordRate == RECORD_RATES[i])
+                        return (size_t)i;
+                }
+                return (size_t)0;
+            },
+            [=](size_t i) { module->recordRate = RECORD_RATES[i]; }));
+        menu->addChild(createIndexSubmenuItem("Format", {"PPM", "Raw RGBA"},
+            [=]() { return (size_t)module->recordFormat; },
+            [=](size_t i) { module->recordFormat = (int)i; }));
+        menu->addChild(createIndexSubmenuItem("Fixed rate size", {"200x155", "400x310"},
+            [=]() { return (size_t)(module->recordScale - 1); },
+            [=](size_t i) { module->recordScale = (int)i + 1; }));
+    }
+
+    void startRecordingDialog() {
+        char* pathC = osdialog_file(OSDIALOG_OPEN_DIR, NULL, NULL, NULL);
+        if (!pathC)
+            return;
+        std::string path = pathC;
+        std::free(pathC);
+
+        std::string error;
+        if (!display->startRecording(path, error))
+            osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, error.c_str());
+    }
+
+    // Everything the Performance menu shows, plus the render settings it was measured with
+    json_t* perfToJson() {
+        JuliaScope* module = getModule<JuliaScope>();
+        json_t* rootJ = ::perfToJson("JuliaScope", module, module->processTimes);
+
+        JuliaRenderStats stats = display->getStats();
+        json_t* renderJ = json_object();
+        PerfSummary frameTimes;
+        if (display->getFrameTimes(frameTimes))
+            json_object_set_new(renderJ, "frameTime", frameTimes.toJson());
+        json_object_set_new(renderJ, "iterationsPerFrame", json_integer(stats.iterations));
+        json_object_set_new(renderJ, "naiveIterationsPerFrame", json_integer(stats.naiveIterations));
+        json_object_set_new(renderJ, "framesRendered", json_integer(stats.completed));
+        json_object_set_new(renderJ, "framesAbandoned", json_integer(stats.frames - stats.completed));
+        json_object_set_new(renderJ, "framesSuperseded", json_integer(stats.dropped));
+        json_object_set_new(renderJ, "framesThrottled", json_integer(display->framesThrottled));
+        json_object_set_new(renderJ, "qualityLevel", json_integer(JuliaGovernor::LEVEL_COUNT - display->governor.getLevel()));
+        json_object_set_new(renderJ, "workers", json_integer(juliaScheduler.getWorkerCount()));
+        json_object_set_new(renderJ, "frameWidth", json_integer(display->imageWidth));
+        json_object_set_new(renderJ, "frameHeight", json_integer(display->imageHeight));
+        json_object_set_new(renderJ, "uiFrames", json_integer(display->uiFrames));
+        json_object_set_new(renderJ, "textureUploads", json_integer(display->uploads));
+        json_object_set_new(renderJ, "textureBytes", json_integer(display->uploadedBytes));
+        json_object_set_new(rootJ, "render", renderJ);
+        return rootJ;
+    }
+
     void drawLabel(NVGcontext* vg, float x, float y, const char* text, NVGcolor color, float size = 10.f) {
         nvgFontSize(vg, size);
         nvgFillColor(vg, color);
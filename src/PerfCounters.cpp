@@ -0,0 +1,136 @@
+#include "PerfCounters.hpp"
+#include <osdialog.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Float bits above the mantissa's top two: the exponent and which quarter of the octave
+const int BUCKET_SHIFT = 21;
+// Bucket 0 starts at 1 ns
+const int BUCKET_OFFSET = 127 << 2;
+
+int bucketOf(uint64_t ns) {
+    if (ns == 0)
+        return 0;
+    float f = (float)ns;
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return std::min((int)(bits >> BUCKET_SHIFT) - BUCKET_OFFSET, PerfHistogram::BUCKETS - 1);
+}
+
+float bucketLimit(int bucket) {
+    uint32_t bits = (uint32_t)(bucket + 1 + BUCKET_OFFSET) << BUCKET_SHIFT;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// "123 ns", "4.56 us" or "7.89 ms"
+std::string formatNs(float ns) {
+    if (ns < 1e3f)
+        return string::f("%.0f ns", ns);
+    if (ns < 1e6f)
+        return string::f("%.2f us", ns * 1e-3f);
+    return string::f("%.2f ms", ns * 1e-6f);
+}
+
+int64_t measureClockOverhead() {
+    typedef std::chrono::steady_clock Clock;
+    int64_t overhead = INT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+        Clock::time_point start = Clock::now();
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        overhead = std::min(overhead, ns);
+    }
+    return overhead;
+}
+
+} // namespace
+
+int64_t perfClockOverheadNs() {
+    static const int64_t overhead = measureClockOverhead();
+    return overhead;
+}
+
+std::string PerfSummary::format() const {
+    return formatNs(mean) + " mean, " + formatNs(p99) + " p99";
+}
+
+json_t* PerfSummary::toJson() const {
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "meanNs", json_real(mean));
+    json_object_set_new(rootJ, "p99Ns", json_real(p99));
+    json_object_set_new(rootJ, "maxNs", json_real(max));
+    json_object_set_new(rootJ, "window", json_integer(count));
+    json_object_set_new(rootJ, "measured", json_integer(total));
+    return rootJ;
+}
+
+void PerfHistogram::add(uint64_t ns) {
+    counts[bucketOf(ns)]++;
+    sumNs += ns;
+    maxNs = std::max(maxNs, ns);
+    total++;
+    if (++count == (uint32_t)window)
+        publish();
+}
+
+void PerfHistogram::publish() {
+    PerfSummary& summary = summaries.write();
+    summary.mean = (float)sumNs / count;
+    summary.max = (float)maxNs;
+    summary.count = count;
+    summary.total = total;
+
+    // The smallest bucket with at least 99% of the window at or below it
+    uint32_t rank = count - count / 100;
+    uint32_t below = 0;
+    int bucket = 0;
+    while ((below += counts[bucket]) < rank)
+        bucket++;
+    summary.p99 = std::min(bucketLimit(bucket), summary.max);
+    summaries.publish();
+
+    std::memset(counts, 0, sizeof(counts));
+    count = 0;
+    sumNs = 0;
+    maxNs = 0;
+}
+
+bool PerfHistogram::read(PerfSummary& summary) {
+    if (summaries.update())
+        received = true;
+    summary = summaries.read();
+    return received;
+}
+
+json_t* perfToJson(const std::string& slug, Module* module, PerfSampler& process) {
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "module", json_string(slug.c_str()));
+    json_object_set_new(rootJ, "sampleRate", json_real(APP->engine->getSampleRate()));
+    PerfSummary summary;
+    if (process.histogram.read(summary)) {
+        json_t* processJ = summary.toJson();
+        json_object_set_new(processJ, "stride", json_integer(PerfSampler::STRIDE));
+        json_object_set_new(rootJ, "process", processJ);
+    }
+    json_object_set_new(rootJ, "settings", module->dataToJson());
+    return rootJ;
+}
+
+void savePerfJson(json_t* rootJ, const std::string& defaultName) {
+    osdialog_filters* filters = osdialog_filters_parse("JSON:json");
+    char* pathC = osdialog_file(OSDIALOG_SAVE, NULL, defaultName.c_str(), filters);
+    osdialog_filters_free(filters);
+    if (!pathC) {
+        json_decref(rootJ);
+        return;
+    }
+    std::string path = pathC;
+    std::free(pathC);
+
+    if (json_dump_file(rootJ, path.c_str(), JSON_INDENT(2)) != 0)
+        osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, ("Cannot write " + path).c_str());
+    json_decref(rootJ);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "plugin.hpp"
+#include "TripleBuffer.hpp"
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+// Durations over one window of measurements, in ns
+struct PerfSummary {
+    float mean = 0.f;
+    float p99 = 0.f;
+    float max = 0.f;
+    // Measurements in the window, and since the counter was created
+    uint32_t count = 0;
+    uint64_t total = 0;
+
+    // "45 ns mean, 120 ns p99"
+    std::string format() const;
+    json_t* toJson() const;
+};
+
+// Distribution of durations measured on one thread. Each measurement lands in one of
+// four buckets per octave, taken from the top bits of its float representation, which
+// costs a few instructions and no atomics. Every window of measurements is summarized
+// and handed to the UI through a triple buffer. The p99 is the upper edge of its
+// bucket, at most 25% above the exact value.
+struct PerfHistogram {
+    static const int BUCKETS = 128;
+
+    explicit PerfHistogram(int window) : window(window) {}
+
+    // Owning thread: one duration
+    void add(uint64_t ns);
+    // UI thread: the summary of the latest full window. Returns false before the first.
+    bool read(PerfSummary& summary);
+
+private:
+    void publish();
+
+    int window;
+    uint32_t counts[BUCKETS] = {};
+    uint32_t count = 0;
+    uint64_t sumNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t total = 0;
+    TripleBuffer<PerfSummary> summaries;
+    bool received = false;
+};
+
+// Time between two back-to-back clock reads, subtracted from every PerfScope timing.
+// Measured on the first call.
+int64_t perfClockOverheadNs();
+
+// Times one call in every STRIDE of a function, such as Module::process, through
+// PerfScope. The other calls cost a decrement and a branch. STRIDE is prime, so the
+// timed calls cycle through every phase of block-rate work like a control divider.
+struct PerfSampler {
+    static const int STRIDE = 37;
+    static const int WINDOW = 1024;
+
+    int countdown = STRIDE;
+    PerfHistogram histogram{WINDOW};
+
+    // Measures the clock here, on the thread creating the module, rather than in the first timed call
+    PerfSampler() { perfClockOverheadNs(); }
+};
+
+struct PerfScope {
+    typedef std::chrono::steady_clock Clock;
+
+    PerfSampler& sampler;
+    bool timed;
+    Clock::time_point start;
+
+    explicit PerfScope(PerfSampler& sampler) : sampler(sampler), timed(--sampler.countdown == 0) {
+        if (timed) {
+            sampler.countdown = PerfSampler::STRIDE;
+            start = Clock::now();
+        }
+    }
+
+    ~PerfScope() {
+        if (timed) {
+            int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            sampler.histogram.add(std::max<int64_t>(ns - perfClockOverheadNs(), 0));
+        }
+    }
+};
+
+// UI thread: what every module's stats dump starts with. The module, the engine sample
+// rate, the process() timings and the module's own settings.
+json_t* perfToJson(const std::string& slug, Module* module, PerfSampler& process);
+
+// UI thread: ask for a file name and write rootJ there as indented JSON. Takes ownership of rootJ.
+void savePerfJson(json_t* rootJ, const std::string& defaultName);
@@ -0,0 +1,175 @@
+#include "PitchTracker.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+const float MIN_FREQ = 20.f;
+const float MAX_FREQ = 5000.f;
+// First dip of the normalized difference below this is taken as the period (YIN's absolute threshold)
+const float THRESHOLD = 0.15f;
+// Without such a dip, the deepest one still counts if it is below this
+const float MAX_APERIODICITY = 0.35f;
+// Mean square below this, about -80 dB under 5V, is silence
+const double SILENCE = 1e-8;
+
+} // namespace
+
+PitchTracker::PitchTracker() {
+    twiddles.resize(FRAME_SIZE / 2);
+    for (int k = 0; k < FRAME_SIZE / 2; k++)
+        twiddles[k] = std::polar(1.f, float(-2.0 * M_PI * k / FRAME_SIZE));
+    bitReverse.resize(FRAME_SIZE);
+    for (int i = 0, j = 0; i < FRAME_SIZE; i++) {
+        bitReverse[i] = j;
+        int bit = FRAME_SIZE >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+    }
+    spectrum.resize(FRAME_SIZE);
+    energy.resize(FRAME_SIZE + 1);
+    difference.resize(WINDOW);
+
+    juliaScheduler.attach(this);
+}
+
+PitchTracker::~PitchTracker() {
+    juliaScheduler.detach(this);
+}
+
+void PitchTracker::push(const float* ring, int index, float sampleRate) {
+    PitchFrame& frame = frames.write();
+    float* out = frame.samples;
+    for (int i = index - 1; i >= 0; i--)
+        *out++ = ring[i];
+    for (int i = FRAME_SIZE - 1; i >= index; i--)
+        *out++ = ring[i];
+    frame.sampleRate = sampleRate;
+    frame.sequence = pushed.load(std::memory_order_relaxed) + 1;
+    uint32_t sequence = frame.sequence;
+    frames.publish();
+    pushed.store(sequence, std::memory_order_release);
+    juliaScheduler.notifyRealtime();
+}
+
+bool PitchTracker::poll(PitchEstimate& estimate) {
+    if (!estimates.update())
+        return false;
+    estimate = estimates.read();
+    return true;
+}
+
+bool PitchTracker::hasWork() const {
+    return pushed.load(std::memory_order_acquire) != analyzed.load(std::memory_order_acquire);
+}
+
+void PitchTracker::run() {
+    // Frames published while the worker was busy are skipped for the latest one
+    if (!frames.update())
+        return;
+    const PitchFrame& frame = frames.read();
+    estimates.write() = analyze(frame);
+    estimates.publish();
+    analyzed.store(frame.sequence, std::memory_order_release);
+}
+
+PitchEstimate PitchTracker::analyze(const PitchFrame& frame) {
+    PitchEstimate estimate;
+    estimate.sequence = frame.sequence;
+    const float* x = frame.samples;
+    float sampleRate = frame.sampleRate;
+
+    // energy[i]: sum of squares of the first i samples
+    energy[0] = 0.0;
+    for (int i = 0; i < FRAME_SIZE; i++)
+        energy[i + 1] = energy[i] + (double)x[i] * x[i];
+    if (energy[WINDOW] < WINDOW * SILENCE)
+        return estimate;
+
+    // Cross-correlation of the window with the whole frame, r(tau) = sum x[j] x[j + tau]
+    // over j < WINDOW. Both real inputs share one complex FFT, window in the real part,
+    // and j + tau stays below FRAME_SIZE, so the circular correlation never wraps.
+    for (int i = 0; i < FRAME_SIZE; i++)
+        spectrum[i] = std::complex<float>(i < WINDOW ? x[i] : 0.f, x[i]);
+    fft(spectrum, false);
+    for (int k = 0; k <= FRAME_SIZE / 2; k++) {
+        std::complex<float> z = spectrum[k];
+        std::complex<float> zMirror = std::conj(spectrum[(FRAME_SIZE - k) & (FRAME_SIZE - 1)]);
+        std::complex<float> a = 0.5f * (z + zMirror);
+        std::complex<float> b = std::complex<float>(0.f, -0.5f) * (z - zMirror);
+        std::complex<float> p = std::conj(a) * b;
+        spectrum[k] = p;
+        spectrum[(FRAME_SIZE - k) & (FRAME_SIZE - 1)] = std::conj(p);
+    }
+    fft(spectrum, true);
+
+    // Cumulative mean normalized difference: d(tau) = e(0) + e(tau) - 2 r(tau), over its running mean
+    int tauMin = std::max(2, (int)(sampleRate / MAX_FREQ));
+    int tauMax = std::min(WINDOW - 2, (int)std::ceil(sampleRate / MIN_FREQ));
+    float scale = 1.f / FRAME_SIZE;
+    double windowEnergy = energy[WINDOW];
+    double sum = 0.0;
+    difference[0] = 1.f;
+    for (int tau = 1; tau <= tauMax + 1; tau++) {
+        double lagEnergy = energy[tau + WINDOW] - energy[tau];
+        double d = std::max(0.0, windowEnergy + lagEnergy - 2.0 * spectrum[tau].real() * scale);
+        sum += d;
+        difference[tau] = sum > 0.0 ? float(d * tau / sum) : 1.f;
+    }
+
+    // The first dip below the threshold, followed to its bottom, so a strong
+    // subharmonic can't win over the fundamental; otherwise the deepest dip
+    int period = -1;
+    for (int tau = tauMin; tau <= tauMax; tau++) {
+        if (difference[tau] < THRESHOLD) {
+            while (tau < tauMax && difference[tau + 1] < difference[tau])
+                tau++;
+            period = tau;
+            break;
+        }
+    }
+    if (period < 0) {
+        period = tauMin;
+        for (int tau = tauMin + 1; tau <= tauMax; tau++) {
+            if (difference[tau] < difference[period])
+                period = tau;
+        }
+        if (difference[period] >= MAX_APERIODICITY)
+            return estimate;
+    }
+
+    // Parabolic interpolation for a period between samples
+    float d0 = difference[period - 1];
+    float d1 = difference[period];
+    float d2 = difference[period + 1];
+    float curvature = d0 - 2.f * d1 + d2;
+    float shift = curvature > 0.f ? clamp(0.5f * (d0 - d2) / curvature, -0.5f, 0.5f) : 0.f;
+
+    estimate.freq = clamp(sampleRate / (period + shift), MIN_FREQ, MAX_FREQ);
+    estimate.voiced = true;
+    return estimate;
+}
+
+// In-place radix-2 FFT of FRAME_SIZE points; inverse without the 1/n scale
+void PitchTracker::fft(std::vector<std::complex<float>>& x, bool inverse) const {
+    for (int i = 0; i < FRAME_SIZE; i++) {
+        int j = bitReverse[i];
+        if (i < j)
+            std::swap(x[i], x[j]);
+    }
+    for (int len = 2; len <= FRAME_SIZE; len <<= 1) {
+        int stride = FRAME_SIZE / len;
+        for (int i = 0; i < FRAME_SIZE; i += len) {
+            for (int k = 0; k < len / 2; k++) {
+                std::complex<float> w = twiddles[k * stride];
+                if (inverse)
+                    w = std::conj(w);
+                std::complex<float> a = x[i + k];
+                std::complex<float> b = x[i + k + len / 2] * w;
+                x[i + k] = a + b;
+                x[i + k + len / 2] = a - b;
+            }
+        }
+    }
+}
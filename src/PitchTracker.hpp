@@ -0,0 +1,75 @@
+#pragma once
+#include "plugin.hpp"
+#include "TripleBuffer.hpp"
+#include "JuliaRender.hpp"
+#include <atomic>
+#include <complex>
+#include <vector>
+
+static const int PITCH_FRAME_SIZE = 4096;
+
+// The most recent PITCH_FRAME_SIZE input samples, newest first, handed from the audio
+// thread to the pitch tracker
+struct PitchFrame {
+    float samples[PITCH_FRAME_SIZE];
+    float sampleRate = 44100.f;
+    uint32_t sequence = 0;
+};
+
+struct PitchEstimate {
+    // Hz, 20 to 5000; only meaningful when voiced
+    float freq = 440.f;
+    // False for silence and for signals without a clear period
+    bool voiced = false;
+    // Sequence number of the frame it was computed from
+    uint32_t sequence = 0;
+};
+
+// YIN pitch estimator, run as a background job on the shared JuliaScheduler workers. The
+// audio thread publishes a frame every HOP samples through a triple buffer, wakes a worker
+// without locking, and picks up the latest estimate through another triple buffer, so it
+// never locks or waits. The difference function is computed from an FFT
+// cross-correlation, which makes every lag up to WINDOW cost O(n log n) in total.
+//
+// An estimate describes the newest WINDOW samples plus one period. It usually reaches the
+// audio thread one analysis after them, or after the render level a busy worker is on; a
+// missed wakeup delays it by one HOP.
+struct PitchTracker : JuliaBackgroundJob {
+    static const int FRAME_SIZE = PITCH_FRAME_SIZE;
+    // Integration window; the longest period found is one sample shorter
+    static const int WINDOW = FRAME_SIZE / 2;
+    static const int HOP = 512;
+
+    PitchTracker();
+    ~PitchTracker();
+
+    // Audio thread: publish the newest FRAME_SIZE samples of a ring buffer of that size,
+    // whose next write position is index
+    void push(const float* ring, int index, float sampleRate);
+    // Audio thread: swap in the latest estimate. Returns false if there is none since the last call.
+    bool poll(PitchEstimate& estimate);
+
+    bool hasWork() const override;
+    void run() override;
+
+    // Any thread: sequence numbers of the last frame published and the last one analyzed.
+    // The worker skips frames it falls behind on, so these are equal once it has caught up.
+    uint32_t getPushed() const { return pushed.load(std::memory_order_acquire); }
+    uint32_t getAnalyzed() const { return analyzed.load(std::memory_order_acquire); }
+
+private:
+    PitchEstimate analyze(const PitchFrame& frame);
+    void fft(std::vector<std::complex<float>>& x, bool inverse) const;
+
+    TripleBuffer<PitchFrame> frames;
+    TripleBuffer<PitchEstimate> estimates;
+    std::atomic<uint32_t> pushed{0};
+    std::atomic<uint32_t> analyzed{0};
+
+    // Worker state, allocated once
+    std::vector<std::complex<float>> twiddles;
+    std::vector<int> bitReverse;
+    std::vector<std::complex<float>> spectrum;
+    std::vector<double> energy;
+    std::vector<float> difference;
+};
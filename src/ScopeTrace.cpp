@@ -0,0 +1,50 @@
+#include "ScopeTrace.hpp"
+#include <algorithm>
+
+void ScopeTrace::completeBin(float sampleRate) {
+    pendingSamples = 0;
+    ScopeTraceBin bin;
+    bin.minLeft = bin.maxLeft = pendingLeft[0];
+    bin.minRight = bin.maxRight = pendingRight[0];
+    for (int i = 1; i < ScopeTraceFrame::BASE_SAMPLES; i++) {
+        bin.minLeft = std::min(bin.minLeft, pendingLeft[i]);
+        bin.maxLeft = std::max(bin.maxLeft, pendingLeft[i]);
+        bin.minRight = std::min(bin.minRight, pendingRight[i]);
+        bin.maxRight = std::max(bin.maxRight, pendingRight[i]);
+    }
+    uint32_t written = pyramid.written + 1;
+    pyramid.level(0)[(written - 1) & (ScopeTraceFrame::BINS - 1)] = bin;
+    // A bin at level k completes with its last level 0 bin, when written is a multiple of 2^k.
+    // Unsigned wraparound keeps the indices consistent, as every level size divides 2^32.
+    for (int k = 1; k < ScopeTraceFrame::LEVELS && !(written & ((1u << k) - 1)); k++) {
+        uint32_t index = (written >> k) - 1;
+        ScopeTraceBin parent = pyramid.bin(k - 1, 2 * index);
+        parent.merge(pyramid.bin(k - 1, 2 * index + 1));
+        pyramid.level(k)[index & (ScopeTraceFrame::levelSize(k) - 1)] = parent;
+    }
+    pyramid.written = written;
+
+    if (written % PUBLISH_BINS == 0)
+        publish(sampleRate);
+}
+
+void ScopeTrace::publish(float sampleRate) {
+    ScopeTraceFrame& frame = frames.write();
+    for (int k = 0; k < ScopeTraceFrame::LEVELS; k++) {
+        uint32_t end = pyramid.written >> k;
+        uint32_t size = ScopeTraceFrame::levelSize(k);
+        uint32_t count = std::min(end - (frame.written >> k), size);
+        ScopeTraceBin* out = frame.level(k);
+        for (uint32_t i = end - count; i != end; i++)
+            out[i & (size - 1)] = pyramid.bin(k, i);
+    }
+    frame.written = pyramid.written;
+    frame.sampleRate = sampleRate;
+    frames.publish();
+}
+
+const ScopeTraceFrame* ScopeTrace::acquire() {
+    if (frames.update())
+        received = true;
+    return received ? &frames.read() : nullptr;
+}
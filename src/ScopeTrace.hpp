@@ -0,0 +1,83 @@
+#pragma once
+#include "TripleBuffer.hpp"
+#include <cstdint>
+
+// Extremes of both channels over a run of samples
+struct ScopeTraceBin {
+    float minLeft = 0.f;
+    float maxLeft = 0.f;
+    float minRight = 0.f;
+    float maxRight = 0.f;
+
+    void merge(const ScopeTraceBin& other) {
+        minLeft = other.minLeft < minLeft ? other.minLeft : minLeft;
+        maxLeft = other.maxLeft > maxLeft ? other.maxLeft : maxLeft;
+        minRight = other.minRight < minRight ? other.minRight : minRight;
+        maxRight = other.maxRight > maxRight ? other.maxRight : maxRight;
+    }
+};
+
+// Min/max pyramid over the newest SAMPLES stereo samples. Level 0 holds one bin per
+// BASE_SAMPLES samples, and each level above it halves the bin count, so any span can
+// be drawn from a few hundred bins whatever its length. Every level is a ring indexed by
+// the bin's absolute number modulo its size.
+struct ScopeTraceFrame {
+    static const int SAMPLES = 4096;
+    static const int BASE_SAMPLES = 4;
+    static const int BINS = SAMPLES / BASE_SAMPLES;
+    static const int LEVELS = 6;
+
+    // Level k starts at 2 * BINS - (2 * BINS >> k) and holds BINS >> k bins
+    ScopeTraceBin bins[2 * BINS];
+    // Level 0 bins completed so far; level k has written >> k, the newest at index (written >> k) - 1
+    uint32_t written = 0;
+    float sampleRate = 44100.f;
+
+    static int levelSize(int level) { return BINS >> level; }
+    ScopeTraceBin* level(int level) { return bins + 2 * BINS - (2 * BINS >> level); }
+    const ScopeTraceBin* level(int level) const { return bins + 2 * BINS - (2 * BINS >> level); }
+
+    // The bin with absolute number index at a level; valid for the newest levelSize(level)
+    const ScopeTraceBin& bin(int level, uint32_t index) const {
+        return this->level(level)[index & (levelSize(level) - 1)];
+    }
+
+    // The finest level that spans samples in at most maxBins bins, or the coarsest one
+    static int levelFor(int samples, int maxBins) {
+        int level = 0;
+        while (level < LEVELS - 1 && samples / (BASE_SAMPLES << level) > maxBins)
+            level++;
+        return level;
+    }
+};
+
+// Builds the pyramid on the audio thread as samples arrive, at an amortized cost of two
+// bin merges per BASE_SAMPLES samples, and hands it to the UI through a triple buffer
+// every PUBLISH_BINS bins. A slot only receives the bins completed since it was last
+// written, so a publish copies a few dozen bins rather than the whole ring.
+struct ScopeTrace {
+    static const int PUBLISH_BINS = 32;
+
+    // Audio thread: append one stereo sample
+    void push(float left, float right, float sampleRate) {
+        pendingLeft[pendingSamples] = left;
+        pendingRight[pendingSamples] = right;
+        if (++pendingSamples == ScopeTraceFrame::BASE_SAMPLES)
+            completeBin(sampleRate);
+    }
+
+    // UI thread: the latest published pyramid, nullptr before the first one
+    const ScopeTraceFrame* acquire();
+
+private:
+    void completeBin(float sampleRate);
+    void publish(float sampleRate);
+
+    ScopeTraceFrame pyramid;
+    // Samples of the level 0 bin being filled, reduced when it completes
+    float pendingLeft[ScopeTraceFrame::BASE_SAMPLES] = {};
+    float pendingRight[ScopeTraceFrame::BASE_SAMPLES] = {};
+    int pendingSamples = 0;
+    TripleBuffer<ScopeTraceFrame> frames;
+    bool received = false;
+};
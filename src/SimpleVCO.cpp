@@ -1,15 +1,27 @@
 #include "plugin.hpp"
+#include "FastMath.hpp"
+#include "BandLimited.hpp"
+#include "TripleBuffer.hpp"
+#include "Wavetable.hpp"
+#include "PerfCounters.hpp"
+#include <osdialog.h>
+
+using simd::float_4;
 
 struct SimpleVCO : Module {
     enum ParamId {
         FREQ_PARAM,
         FINE_PARAM,
         FM_PARAM,
+        VOICES_PARAM,
+        SPREAD_PARAM,
+        WAVE_POSITION_PARAM,
         PARAMS_LEN
     };
     enum InputId {
         VOCT_INPUT,
         FM_INPUT,
+        SYNC_INPUT,
         INPUTS_LEN
     };
     enum OutputId {
@@ -23,57 +35,398 @@ struct SimpleVCO : Module {
         LIGHTS_LEN
     };
 
-    float phase = 0.f;
+    // Rising edges through this voltage reset the phase
+    static constexpr float SYNC_THRESHOLD = 0.1f;
+
+    static const int MAX_VOICES = 8;
+    // Widest detune, at full SPREAD: the outer voices sit this many semitones from the center
+    static constexpr float MAX_SPREAD = 1.f;
+
+    // 4 oscillators, one per SIMD lane: 4 channels, or 4 unison voices
+    struct Oscillator {
+        float_4 phase = 0.f;
+        // SYNC voltage at the previous (sub)sample
+        float_4 lastSync = 0.f;
+        BlepDelay<float_4> blep[OUTPUTS_LEN];
+    };
+
+    // What processOscillator() generates, fixed for one process() call
+    struct OscillatorSettings {
+        bool connected[OUTPUTS_LEN];
+        bool syncConnected;
+        // Played on the sine output instead of the sine when set
+        const Wavetable* wavetable;
+        float wavePosition;
+    };
+
+    // Oversampled modes: 4x to 2x, then 2x to 1x, for 4 channels
+    struct Decimator {
+        HalfBandDecimator<float_4, 4> firstStage[OUTPUTS_LEN];
+        HalfBandDecimator<float_4, 8> lastStage[OUTPUTS_LEN];
+    };
+
+    // Up to 16 polyphonic channels, processed 4 at a time
+    Oscillator oscillators[4];
+    // Unison: up to 8 voices for each of 4 channels, MAX_VOICES oscillators per group of 4
+    // channels. The voices are packed channel by channel, 4 to an oscillator, so only the
+    // last oscillator of a group has idle lanes.
+    Oscillator unisonOscillators[16 * MAX_VOICES / 4];
+    Decimator decimators[4];
+
+    // Pitch ratio of every packed unison lane, and the gain of every voice, recomputed when
+    // VOICES or SPREAD change
+    int unisonVoices = 0;
+    float unisonSpread = -1.f;
+    float_4 laneDetuneRatios[MAX_VOICES];
+    float unisonGain = 0.f;
+
+    // Polynomial exp2 and sine instead of the libm-style simd::pow and simd::sin
+    bool fastMath = true;
+    // 1, 2 or 4
+    int oversample = 1;
+
+    // Wavetable handed from the UI thread to the audio thread, which only reads it. Tables
+    // are released on the UI thread when their slot is overwritten.
+    TripleBuffer<std::shared_ptr<const Wavetable>> wavetables;
+    // Audio thread: the table in the read slot
+    const Wavetable* wavetable = nullptr;
+    // UI thread: file of the loaded table, empty if none
+    std::string wavetablePath;
+
+    // Cost of process(), measured on the audio thread
+    PerfSampler processTimes;
 
     SimpleVCO() {
         config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
         configParam(FREQ_PARAM, -3.f, 3.f, 0.f, "Frequency", " octaves");
         configParam(FINE_PARAM, -0.5f, 0.5f, 0.f, "Fine tune", " semitones", 0.f, 12.f);
         configParam(FM_PARAM, -1.f, 1.f, 0.f, "FM amount", "%", 0.f, 100.f);
+        configParam(VOICES_PARAM, 1.f, MAX_VOICES, 1.f, "Unison voices")->snapEnabled = true;
+        configParam(SPREAD_PARAM, 0.f, 1.f, 0.2f, "Unison detune", " cents", 0.f, 100.f * MAX_SPREAD);
+        configParam(WAVE_POSITION_PARAM, 0.f, 1.f, 0.f, "Wavetable position", "%", 0.f, 100.f);
         configInput(VOCT_INPUT, "V/Oct");
         configInput(FM_INPUT, "FM");
+        configInput(SYNC_INPUT, "Hard sync");
         configOutput(SINE_OUTPUT, "Sine");
         configOutput(TRI_OUTPUT, "Triangle");
         configOutput(SAW_OUTPUT, "Saw");
         configOutput(SQUARE_OUTPUT, "Square");
+
+        // Spread the unison lanes' starting phases so a new stack doesn't start with one big spike.
+        // A channel's voices are consecutive lanes, so they get consecutive golden ratio steps.
+        for (int i = 0; i < 16 * MAX_VOICES / 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                float lane = (i % MAX_VOICES) * 4 + j;
+                unisonOscillators[i].phase[j] = lane * 0.618034f - std::floor(lane * 0.618034f);
+            }
+        }
     }
 
     void process(const ProcessArgs& args) override {
+        PerfScope timing(processTimes);
+
+        // V/Oct sets the channel count; a mono FM cable modulates every channel
+        int channels = std::max(1, inputs[VOCT_INPUT].getChannels());
+
+        if (wavetables.update())
+            wavetable = wavetables.read().get();
+
+        if (fastMath)
+            processChannels<true>(args, channels);
+        else
+            processChannels<false>(args, channels);
+
+        for (int i = 0; i < OUTPUTS_LEN; i++)
+            outputs[i].setChannels(channels);
+    }
+
+    template <bool FAST_MATH>
+    void processChannels(const ProcessArgs& args, int channels) {
         float freqParam = params[FREQ_PARAM].getValue();
         float fineParam = params[FINE_PARAM].getValue();
         float fmParam = params[FM_PARAM].getValue();
+        int voices = clamp((int)std::round(params[VOICES_PARAM].getValue()), 1, MAX_VOICES);
+
+        float basePitch = freqParam + fineParam / 12.f;
+
+        OscillatorSettings settings;
+        const bool* connected = settings.connected;
+        for (int i = 0; i < OUTPUTS_LEN; i++)
+            settings.connected[i] = outputs[i].isConnected();
+        bool syncConnected = settings.syncConnected = inputs[SYNC_INPUT].isConnected();
+        settings.wavetable = wavetable;
+        settings.wavePosition = params[WAVE_POSITION_PARAM].getValue();
+
+        // Nyquist of the output rate; the oversampled rate only adds headroom for the corrections
+        float maxFreq = args.sampleRate / 2.f;
+        float sampleTime = args.sampleTime / oversample;
+
+        if (voices > 1)
+            updateUnison(voices, params[SPREAD_PARAM].getValue());
+
+        for (int c = 0; c < channels; c += 4) {
+            // Idle lanes stay at 0, so nothing undefined reaches the decimators or the outputs
+            float_4 out[OUTPUTS_LEN][4] = {};
+
+            if (voices == 1) {
+                float_4 pitch = basePitch;
+                pitch += inputs[VOCT_INPUT].getPolyVoltageSimd<float_4>(c);
+                pitch += inputs[FM_INPUT].getPolyVoltageSimd<float_4>(c) * fmParam;
+
+                float_4 freq = dsp::FREQ_C4 * (FAST_MATH ? fastExp2(pitch) : simd::pow(2.f, pitch));
+                freq = simd::clamp(freq, 0.f, maxFreq);
+                float_4 sync = syncConnected ? inputs[SYNC_INPUT].getPolyVoltageSimd<float_4>(c) : 0.f;
+                processOscillator<FAST_MATH>(oscillators[c / 4], freq * sampleTime, sync, settings, out);
+            }
+            else {
+                // One pitch per channel, then the voices of all the group's channels 4 at a time,
+                // each lane mixed into its channel's lane
+                int groupChannels = std::min(4, channels - c);
+                float channelFreq[4];
+                float channelSync[4];
+                for (int j = 0; j < groupChannels; j++) {
+                    int channel = c + j;
+                    float pitch = basePitch;
+                    pitch += inputs[VOCT_INPUT].getPolyVoltage(channel);
+                    pitch += inputs[FM_INPUT].getPolyVoltage(channel) * fmParam;
+                    channelFreq[j] = dsp::FREQ_C4 * (FAST_MATH ? fastExp2(pitch) : std::pow(2.f, pitch));
+                    channelSync[j] = syncConnected ? inputs[SYNC_INPUT].getPolyVoltage(channel) : 0.f;
+                }
+
+                int lanes = groupChannels * voices;
+                for (int g = 0; g * 4 < lanes; g++) {
+                    // Idle lanes after the last voice follow the last channel and are never mixed
+                    float_4 freq;
+                    float_4 sync;
+                    for (int l = 0; l < 4; l++) {
+                        int j = std::min((g * 4 + l) / voices, groupChannels - 1);
+                        freq[l] = channelFreq[j];
+                        sync[l] = channelSync[j];
+                    }
+                    float_4 voiceFreq = simd::clamp(freq * laneDetuneRatios[g], 0.f, maxFreq);
+                    float_4 voiceOut[OUTPUTS_LEN][4];
+                    Oscillator& osc = unisonOscillators[(c / 4) * MAX_VOICES + g];
+                    processOscillator<FAST_MATH>(osc, voiceFreq * sampleTime, sync, settings, voiceOut);
+
+                    for (int l = 0; l < 4 && g * 4 + l < lanes; l++) {
+                        int j = (g * 4 + l) / voices;
+                        for (int i = 0; i < OUTPUTS_LEN; i++) {
+                            if (!connected[i])
+                                continue;
+                            for (int k = 0; k < oversample; k++)
+                                out[i][k][j] += unisonGain * voiceOut[i][k][l];
+                        }
+                    }
+                }
+            }
 
-        float pitch = freqParam + fineParam / 12.f;
-        pitch += inputs[VOCT_INPUT].getVoltage();
-        pitch += inputs[FM_INPUT].getVoltage() * fmParam;
+            Decimator& d = decimators[c / 4];
+            for (int i = 0; i < OUTPUTS_LEN; i++) {
+                if (!connected[i])
+                    continue;
+                float_4 y = out[i][0];
+                if (oversample == 2) {
+                    y = d.lastStage[i].process(out[i][0], out[i][1]);
+                }
+                else if (oversample == 4) {
+                    float_4 y0 = d.firstStage[i].process(out[i][0], out[i][1]);
+                    float_4 y1 = d.firstStage[i].process(out[i][2], out[i][3]);
+                    y = d.lastStage[i].process(y0, y1);
+                }
+                outputs[i].setVoltageSimd(5.f * y, c);
+            }
+        }
+    }
 
-        float freq = dsp::FREQ_C4 * std::pow(2.f, pitch);
-        freq = clamp(freq, 0.f, args.sampleRate / 2.f);
+    // Advances 4 oscillators by one output sample, writing oversample band-limited samples per connected output
+    template <bool FAST_MATH>
+    void processOscillator(Oscillator& osc, float_4 deltaPhase, float_4 syncVoltage, const OscillatorSettings& settings,
+        float_4 out[OUTPUTS_LEN][4]) {
+        const bool* connected = settings.connected;
+        bool syncConnected = settings.syncConnected;
 
-        phase += freq * args.sampleTime;
-        if (phase >= 1.f)
-            phase -= 1.f;
+        // SYNC is interpolated linearly across the oversampled steps
+        float_4 syncStep = 0.f;
+        if (syncConnected)
+            syncStep = (syncVoltage - osc.lastSync) / oversample;
 
-        // Generate waveforms
-        if (outputs[SINE_OUTPUT].isConnected()) {
-            float sine = std::sin(2.f * M_PI * phase);
-            outputs[SINE_OUTPUT].setVoltage(5.f * sine);
+        // Mip levels follow the pitch at the output rate, so every mode stays alias-free
+        WavetableReader readers[4];
+        const Wavetable* wavetable = connected[SINE_OUTPUT] ? settings.wavetable : nullptr;
+        if (wavetable) {
+            for (int j = 0; j < 4; j++)
+                readers[j].set(*wavetable, deltaPhase[j] * oversample, settings.wavePosition);
         }
 
-        if (outputs[TRI_OUTPUT].isConnected()) {
-            float tri = 4.f * std::abs(phase - 0.5f) - 1.f;
-            outputs[TRI_OUTPUT].setVoltage(5.f * tri);
+        for (int k = 0; k < oversample; k++) {
+            float_4 oldPhase = osc.phase;
+            float_4 phase = oldPhase + deltaPhase;
+            float_4 wrapped = phase >= 1.f;
+            phase = simd::ifelse(wrapped, phase - 1.f, phase);
+            // deltaPhase is at most 1/2, so a sample can't both wrap and cross 1/2
+            float_4 halfway = (oldPhase < 0.5f) & (phase >= 0.5f);
+
+            float_4 synced = 0.f;
+            float_4 lastSync = osc.lastSync;
+            float_4 sync = lastSync + syncStep;
+            if (syncConnected) {
+                synced = (lastSync < SYNC_THRESHOLD) & (sync >= SYNC_THRESHOLD);
+                osc.lastSync = sync;
+            }
+
+            // Discontinuities are rare, so their positions are only computed when there is one:
+            // the time since the wrap, the halfway point or the sync reset, in samples
+            bool edge = simd::movemask(wrapped | halfway | synced);
+            bool anySynced = edge && simd::movemask(synced);
+            float_4 wrapD = 0.f;
+            float_4 halfwayD = 0.f;
+            float_4 syncD = 0.f;
+            float_4 syncPhase = 0.f;
+            if (edge) {
+                wrapD = phase / deltaPhase;
+                halfwayD = (phase - 0.5f) / deltaPhase;
+            }
+            if (anySynced) {
+                // Where the SYNC signal crossed the threshold, interpolated linearly
+                syncD = (sync - SYNC_THRESHOLD) / (sync - lastSync);
+                // Edges after the reset never happened
+                wrapped = simd::ifelse(synced & (wrapD < syncD), 0.f, wrapped);
+                halfway = simd::ifelse(synced & (halfwayD < syncD), 0.f, halfway);
+                // Phase just before the reset, then restart from 0 at the crossing. deltaPhase is
+                // at most 1/2, so the restarted phase can't reach the halfway point this sample.
+                syncPhase = oldPhase + (1.f - syncD) * deltaPhase;
+                syncPhase = simd::ifelse(syncPhase >= 1.f, syncPhase - 1.f, syncPhase);
+                phase = simd::ifelse(synced, syncD * deltaPhase, phase);
+            }
+            osc.phase = phase;
+
+            // Generate waveforms, delayed by one sample like the corrected ones
+            if (wavetable) {
+                float_4 wave;
+                for (int j = 0; j < 4; j++)
+                    wave[j] = readers[j].read(phase[j]);
+                if (anySynced) {
+                    // Back to the start of the cycle
+                    float_4 jump;
+                    for (int j = 0; j < 4; j++)
+                        jump[j] = readers[j].read(0.f) - readers[j].read(syncPhase[j]);
+                    osc.blep[SINE_OUTPUT].addStep(synced, syncD, jump);
+                }
+                out[SINE_OUTPUT][k] = osc.blep[SINE_OUTPUT].process(wave);
+            }
+            else if (connected[SINE_OUTPUT]) {
+                float_4 sine = sin2Pi<FAST_MATH>(phase);
+                if (anySynced) {
+                    // Back to 0 with a slope of 2 pi per cycle
+                    float_4 cosSync = sin2Pi<FAST_MATH>(syncPhase + 0.25f);
+                    osc.blep[SINE_OUTPUT].addStep(synced, syncD, -sin2Pi<FAST_MATH>(syncPhase));
+                    osc.blep[SINE_OUTPUT].addRamp(synced, syncD, 2.f * float(M_PI) * deltaPhase * (1.f - cosSync));
+                }
+                out[SINE_OUTPUT][k] = osc.blep[SINE_OUTPUT].process(sine);
+            }
+
+            if (connected[TRI_OUTPUT]) {
+                float_4 tri = 4.f * simd::abs(phase - 0.5f) - 1.f;
+                if (edge) {
+                    // Slope turns from -4 to +4 per cycle halfway, and back at the wrap
+                    osc.blep[TRI_OUTPUT].addRamp(halfway, halfwayD, 8.f * deltaPhase);
+                    osc.blep[TRI_OUTPUT].addRamp(wrapped, wrapD, -8.f * deltaPhase);
+                }
+                if (anySynced) {
+                    // Back to +1, falling; the slope only changes if it was rising
+                    float_4 rising = syncPhase >= 0.5f;
+                    osc.blep[TRI_OUTPUT].addStep(synced, syncD, 2.f - 4.f * simd::abs(syncPhase - 0.5f));
+                    osc.blep[TRI_OUTPUT].addRamp(synced & rising, syncD, -8.f * deltaPhase);
+                }
+                out[TRI_OUTPUT][k] = osc.blep[TRI_OUTPUT].process(tri);
+            }
+
+            if (connected[SAW_OUTPUT]) {
+                float_4 saw = 2.f * phase - 1.f;
+                if (edge)
+                    osc.blep[SAW_OUTPUT].addStep(wrapped, wrapD, -2.f);
+                if (anySynced)
+                    osc.blep[SAW_OUTPUT].addStep(synced, syncD, -2.f * syncPhase);
+                out[SAW_OUTPUT][k] = osc.blep[SAW_OUTPUT].process(saw);
+            }
+
+            if (connected[SQUARE_OUTPUT]) {
+                float_4 square = simd::ifelse(phase < 0.5f, 1.f, -1.f);
+                if (edge) {
+                    osc.blep[SQUARE_OUTPUT].addStep(halfway, halfwayD, -2.f);
+                    osc.blep[SQUARE_OUTPUT].addStep(wrapped, wrapD, 2.f);
+                }
+                if (anySynced)
+                    osc.blep[SQUARE_OUTPUT].addStep(synced & (syncPhase >= 0.5f), syncD, 2.f);
+                out[SQUARE_OUTPUT][k] = osc.blep[SQUARE_OUTPUT].process(square);
+            }
         }
 
-        if (outputs[SAW_OUTPUT].isConnected()) {
-            float saw = 2.f * phase - 1.f;
-            outputs[SAW_OUTPUT].setVoltage(5.f * saw);
+    }
+
+    // Voices spaced evenly across +/-spread. Detuned voices add up in power, so they're mixed at
+    // 1/sqrt(voices) to keep the level of a single voice, but never above 2/voices: when all
+    // phases line up the stack peaks at 10V at most.
+    void updateUnison(int voices, float spread) {
+        if (voices == unisonVoices && spread == unisonSpread)
+            return;
+        unisonVoices = voices;
+        unisonSpread = spread;
+
+        unisonGain = std::min(1.f / std::sqrt((float)voices), 2.f / voices);
+        for (int lane = 0; lane < 4 * MAX_VOICES; lane++) {
+            int v = lane % voices;
+            float offset = spread * MAX_SPREAD * (2.f * v / (voices - 1) - 1.f);
+            laneDetuneRatios[lane / 4][lane % 4] = std::pow(2.f, offset / 12.f);
+        }
+    }
+
+    template <bool FAST_MATH>
+    static float_4 sin2Pi(float_4 phase) {
+        return FAST_MATH ? fastSin2Pi(phase) : simd::sin(2.f * float(M_PI) * phase);
+    }
+
+    json_t* dataToJson() override {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "fastMath", json_boolean(fastMath));
+        json_object_set_new(rootJ, "oversample", json_integer(oversample));
+        if (!wavetablePath.empty())
+            json_object_set_new(rootJ, "wavetable", json_string(wavetablePath.c_str()));
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override {
+        json_t* fastMathJ = json_object_get(rootJ, "fastMath");
+        if (fastMathJ)
+            fastMath = json_boolean_value(fastMathJ);
+        json_t* oversampleJ = json_object_get(rootJ, "oversample");
+        if (oversampleJ)
+            setOversample(json_integer_value(oversampleJ));
+        json_t* wavetableJ = json_object_get(rootJ, "wavetable");
+        if (wavetableJ) {
+            // A missing file is kept in the patch, in case it comes back
+            std::string error;
+            if (!setWavetable(json_string_value(wavetableJ), error))
+                wavetablePath = json_string_value(wavetableJ);
         }
+    }
 
-        if (outputs[SQUARE_OUTPUT].isConnected()) {
-            float square = phase < 0.5f ? 1.f : -1.f;
-            outputs[SQUARE_OUTPUT].setVoltage(5.f * square);
+    // UI thread: load a table, or unload with an empty path, and hand it to the audio thread
+    bool setWavetable(const std::string& path, std::string& error) {
+        std::shared_ptr<const Wavetable> table;
+        if (!path.empty()) {
+            table = loadWavetable(path, error);
+            if (!table)
+                return false;
         }
+        wavetablePath = path;
+        wavetables.write() = table;
+        wavetables.publish();
+        return true;
+    }
+
+    void setOversample(int oversample) {
+        this->oversample = (oversample >= 4) ? 4 : (oversample >= 2) ? 2 : 1;
     }
 };
 
@@ -91,11 +444,15 @@ struct SimpleVCOWidget : ModuleWidget {
         // Knobs - positioned in center column
         addParam(createParamCentered<RoundBigBlackKnob>(mm2px(Vec(15.24, 30)), module, SimpleVCO::FREQ_PARAM));
         addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(15.24, 50)), module, SimpleVCO::FINE_PARAM));
-        addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(15.24, 65)), module, SimpleVCO::FM_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(5.5, 50)), module, SimpleVCO::VOICES_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(24.98, 50)), module, SimpleVCO::SPREAD_PARAM));
+        addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(22.86, 65)), module, SimpleVCO::FM_PARAM));
 
         // Inputs
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.62, 85)), module, SimpleVCO::VOCT_INPUT));
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(22.86, 85)), module, SimpleVCO::FM_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.62, 65)), module, SimpleVCO::SYNC_INPUT));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(15.24, 73)), module, SimpleVCO::WAVE_POSITION_PARAM));
 
         // Outputs - bottom row
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(7.62, 100)), module, SimpleVCO::SINE_OUTPUT));
@@ -103,6 +460,52 @@ struct SimpleVCOWidget : ModuleWidget {
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(7.62, 115)), module, SimpleVCO::SAW_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(22.86, 115)), module, SimpleVCO::SQUARE_OUTPUT));
     }
+
+    void appendContextMenu(Menu* menu) override {
+        SimpleVCO* module = getModule<SimpleVCO>();
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createBoolPtrMenuItem("Fast exp2/sine approximations", "", &module->fastMath));
+        menu->addChild(createIndexSubmenuItem("Oversampling", {"Off", "2x", "4x"},
+            [=]() { return module->oversample / 2; },
+            [=](size_t index) { module->setOversample(1 << index); }));
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createMenuItem("Load wavetable...", "", [=]() { loadWavetableDialog(module); }));
+        if (!module->wavetablePath.empty()) {
+            menu->addChild(createMenuItem("Unload " + system::getFilename(module->wavetablePath), "", [=]() {
+                std::string error;
+                module->setWavetable("", error);
+            }));
+        }
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createMenuLabel("Performance"));
+        PerfSummary process;
+        if (module->processTimes.histogram.read(process))
+            menu->addChild(createMenuLabel("Process: " + process.format() + " per sample"));
+        else
+            menu->addChild(createMenuLabel("Process: measuring"));
+        menu->addChild(createMenuItem("Save performance stats...", "", [=]() {
+            json_t* rootJ = perfToJson("SimpleVCO", module, module->processTimes);
+            json_object_set_new(rootJ, "channels", json_integer(std::max(1, module->inputs[SimpleVCO::VOCT_INPUT].getChannels())));
+            savePerfJson(rootJ, "SimpleVCO-performance.json");
+        }));
+    }
+
+    static void loadWavetableDialog(SimpleVCO* module) {
+        osdialog_filters* filters = osdialog_filters_parse("WAV:wav");
+        char* pathC = osdialog_file(OSDIALOG_OPEN, NULL, NULL, filters);
+        osdialog_filters_free(filters);
+        if (!pathC)
+            return;
+        std::string path = pathC;
+        std::free(pathC);
+
+        std::string error;
+        if (!module->setWavetable(path, error))
+            osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, error.c_str());
+    }
 };
 
 Model* modelSimpleVCO = createModel<SimpleVCO, SimpleVCOWidget>("SimpleVCO");
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Single-producer, single-consumer FIFO of at most CAPACITY values in a fixed ring.
+// Neither side locks, waits or allocates: push() fails when the ring is full and pop()
+// when it is empty. Unlike TripleBuffer, every value pushed is delivered.
+template <typename T, int CAPACITY>
+struct SpscQueue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    // Producer: append value. Returns false, dropping it, if the queue is full.
+    bool push(const T& value) {
+        uint32_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - head.load(std::memory_order_acquire) == (uint32_t)CAPACITY)
+            return false;
+        slots[tail & (CAPACITY - 1)] = value;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: take the oldest value. Returns false if the queue is empty.
+    bool pop(T& value) {
+        uint32_t head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire))
+            return false;
+        value = slots[head & (CAPACITY - 1)];
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: drop everything queued so far
+    void clear() {
+        head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    T slots[CAPACITY] = {};
+    // Free-running counts of values pushed and popped; unsigned wraparound keeps their difference right
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+};
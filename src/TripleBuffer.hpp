@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Single-producer, single-consumer triple buffer. The writer fills its own slot and
+// publishes it with one atomic exchange; the reader swaps in the most recently
+// published slot the same way. Neither side ever locks or waits, and the reader
+// always sees a complete value from a single publish().
+template <typename T>
+struct TripleBuffer {
+    // Writer: the slot to fill before publish()
+    T& write() { return slots[writeIndex]; }
+
+    // Writer: make the written slot the latest value
+    void publish() {
+        uint8_t old = middle.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        writeIndex = old & INDEX_MASK;
+    }
+
+    // Reader: swap in the latest value if one was published since the last call.
+    // Returns whether read() changed.
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT))
+            return false;
+        uint8_t old = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = old & INDEX_MASK;
+        return true;
+    }
+
+    // Reader: the value swapped in by the last update()
+    const T& read() const { return slots[readIndex]; }
+
+private:
+    static const uint8_t INDEX_MASK = 3;
+    static const uint8_t FRESH_BIT = 4;
+
+    T slots[3] = {};
+    // Slot shared between the two sides, with FRESH_BIT set while the reader hasn't taken it
+    std::atomic<uint8_t> middle{1};
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 2;
+};
@@ -0,0 +1,400 @@
+#include "Wavetable.hpp"
+#include <cmath>
+#include <complex>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#if defined ARCH_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Bump when the cache layout or the mip level computation changes
+const uint32_t CACHE_VERSION = 1;
+const char CACHE_MAGIC[8] = {'T', 'V', 'C', 'O', 'W', 'T', 'B', 'L'};
+// Table data starts here, so it stays aligned for any access pattern
+const size_t CACHE_HEADER_SIZE = 128;
+// When a new table is cached, files of tables that aren't loaded are removed until the cache
+// is under this size. A removed table is simply rebuilt the next time it loads.
+const uint64_t CACHE_LIMIT_BYTES = 256ull << 20;
+// Mip levels keep at least 4 samples per harmonic, and never fewer than this
+const int MIN_LEVEL_LENGTH = 64;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t frameLength;
+    uint32_t frames;
+    uint32_t levels;
+    uint32_t levelLength[Wavetable::MAX_LEVELS];
+};
+static_assert(sizeof(CacheHeader) <= CACHE_HEADER_SIZE, "cache header too large");
+
+// Level layout for a frame length, and the total number of samples it takes
+size_t layoutLevels(Wavetable& table) {
+    table.levels = 0;
+    size_t offset = 0;
+    for (int harmonics = table.frameLength / 2; harmonics >= 1 && table.levels < Wavetable::MAX_LEVELS; harmonics /= 2) {
+        int level = table.levels++;
+        table.levelLength[level] = clamp(4 * harmonics, MIN_LEVEL_LENGTH, table.frameLength);
+        table.levelOffset[level] = offset;
+        offset += (size_t)table.frames * (table.levelLength[level] + 1);
+    }
+    return offset;
+}
+
+// In-place radix-2 FFT; inverse without the 1/n scale
+void fft(std::vector<std::complex<double>>& x, bool inverse) {
+    size_t n = x.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+        if (i < j)
+            std::swap(x[i], x[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        double angle = (inverse ? 2.0 : -2.0) * M_PI / len;
+        std::complex<double> step(std::cos(angle), std::sin(angle));
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<double> w(1.0);
+            for (size_t k = 0; k < len / 2; k++) {
+                std::complex<double> a = x[i + k];
+                std::complex<double> b = x[i + k + len / 2] * w;
+                x[i + k] = a + b;
+                x[i + k + len / 2] = a - b;
+                w *= step;
+            }
+        }
+    }
+}
+
+template <typename T>
+T readLE(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// First channel of a PCM (16, 24 or 32 bit) or 32-bit float WAV file
+bool decodeWav(const std::vector<uint8_t>& file, std::vector<float>& samples, std::string& error) {
+    if (file.size() < 12 || std::memcmp(&file[0], "RIFF", 4) || std::memcmp(&file[8], "WAVE", 4)) {
+        error = "Not a WAV file";
+        return false;
+    }
+    int format = 0, channels = 0, bits = 0;
+    size_t pos = 12;
+    while (pos + 8 <= file.size()) {
+        const uint8_t* chunk = &file[pos];
+        size_t size = readLE<uint32_t>(chunk + 4);
+        size_t body = pos + 8;
+        size = std::min(size, file.size() - body);
+        if (!std::memcmp(chunk, "fmt ", 4) && size >= 16) {
+            format = readLE<uint16_t>(&file[body]);
+            channels = readLE<uint16_t>(&file[body + 2]);
+            bits = readLE<uint16_t>(&file[body + 14]);
+            // WAVE_FORMAT_EXTENSIBLE: the real format is the start of the sub-format GUID
+            if (format == 0xfffe && size >= 26)
+                format = readLE<uint16_t>(&file[body + 24]);
+        }
+        else if (!std::memcmp(chunk, "data", 4)) {
+            if (channels <= 0) {
+                error = "WAV data before format";
+                return false;
+            }
+            int bytes = bits / 8;
+            bool pcm = (format == 1 && (bits == 16 || bits == 24 || bits == 32));
+            bool ieee = (format == 3 && bits == 32);
+            if (!pcm && !ieee) {
+                error = "Unsupported WAV format (16, 24 or 32-bit PCM, or 32-bit float)";
+                return false;
+            }
+            size_t count = size / (bytes * channels);
+            samples.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t* p = &file[body + i * bytes * channels];
+                if (ieee)
+                    samples[i] = readLE<float>(p);
+                else if (bits == 16)
+                    samples[i] = readLE<int16_t>(p) / 32768.f;
+                else if (bits == 24)
+                    samples[i] = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) / 2147483648.f;
+                else
+                    samples[i] = readLE<int32_t>(p) / 2147483648.f;
+            }
+            return true;
+        }
+        pos = body + size + (size & 1);
+    }
+    error = "WAV file has no audio data";
+    return false;
+}
+
+// Splits the samples into frames and computes the mip levels into the cache file layout
+bool buildTable(const std::vector<float>& samples, std::vector<uint8_t>& cache, std::string& error) {
+    Wavetable table;
+    // The largest common frame size that divides the file; Serum-style tables use 2048
+    static const int FRAME_LENGTHS[] = {2048, 1024, 512, 256};
+    for (int length : FRAME_LENGTHS) {
+        if (!samples.empty() && samples.size() % length == 0) {
+            table.frameLength = length;
+            break;
+        }
+    }
+    if (table.frameLength == 0) {
+        error = "Wavetable length must be a multiple of 256, 512, 1024 or 2048 samples";
+        return false;
+    }
+    table.frames = std::min((int)(samples.size() / table.frameLength), (int)Wavetable::MAX_FRAMES);
+    size_t size = layoutLevels(table);
+
+    cache.assign(CACHE_HEADER_SIZE + size * sizeof(float), 0);
+    CacheHeader header = {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.frameLength = table.frameLength;
+    header.frames = table.frames;
+    header.levels = table.levels;
+    for (int level = 0; level < table.levels; level++)
+        header.levelLength[level] = table.levelLength[level];
+    std::memcpy(&cache[0], &header, sizeof(header));
+    float* data = (float*)&cache[CACHE_HEADER_SIZE];
+
+    // One scale for the whole table, so frames keep their relative levels
+    float peak = 0.f;
+    for (float x : samples)
+        peak = std::max(peak, std::fabs(x));
+    if (peak <= 0.f) {
+        error = "Wavetable is silent";
+        return false;
+    }
+
+    int n = table.frameLength;
+    std::vector<std::complex<double>> spectrum(n);
+    std::vector<std::complex<double>> bins;
+    for (int frame = 0; frame < table.frames; frame++) {
+        for (int i = 0; i < n; i++)
+            spectrum[i] = samples[(size_t)frame * n + i] / peak;
+        fft(spectrum, false);
+
+        for (int level = 0; level < table.levels; level++) {
+            int length = table.levelLength[level];
+            // Drop DC and the Nyquist bin along with everything above the level's cutoff
+            int harmonics = std::min((n / 2) >> level, length / 2 - 1);
+            bins.assign(length, 0.0);
+            for (int h = 1; h <= harmonics && h < n / 2; h++) {
+                bins[h] = spectrum[h];
+                bins[length - h] = spectrum[n - h];
+            }
+            fft(bins, true);
+            float* out = data + table.levelOffset[level] + (size_t)frame * (length + 1);
+            for (int i = 0; i < length; i++)
+                out[i] = (float)(bins[i].real() / n);
+            out[length] = out[0];
+        }
+    }
+    return true;
+}
+
+// Fills in the layout from a cache file image, checking that it's complete
+bool parseCache(const uint8_t* bytes, size_t size, Wavetable& table) {
+    if (size < CACHE_HEADER_SIZE)
+        return false;
+    CacheHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) || header.version != CACHE_VERSION)
+        return false;
+    if (header.frameLength < 256 || header.frameLength > 2048 || header.frames < 1 || header.frames > Wavetable::MAX_FRAMES)
+        return false;
+    table.frameLength = header.frameLength;
+    table.frames = header.frames;
+    size_t samples = layoutLevels(table);
+    if ((int)header.levels != table.levels || size != CACHE_HEADER_SIZE + samples * sizeof(float))
+        return false;
+    table.data = (const float*)(bytes + CACHE_HEADER_SIZE);
+    return true;
+}
+
+// A table read from its cache file through a read-only mapping
+struct MappedWavetable : Wavetable {
+#if defined ARCH_WIN
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+    void* view = nullptr;
+    size_t size = 0;
+
+    bool open(const std::string& path) {
+#if defined ARCH_WIN
+        std::wstring pathW = string::UTF8toUTF16(path);
+        file = CreateFileW(pathW.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+            return false;
+        size = (size_t)fileSize.QuadPart;
+        mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping)
+            return false;
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) || st.st_size == 0)
+            return false;
+        size = (size_t)st.st_size;
+        view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED)
+            view = nullptr;
+#endif
+        return view && parseCache((const uint8_t*)view, size, *this);
+    }
+
+    ~MappedWavetable() {
+#if defined ARCH_WIN
+        if (view)
+            UnmapViewOfFile(view);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (view)
+            munmap(view, size);
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+};
+
+// Fallback when the cache file can't be written: the table lives on the heap, still shared
+struct MemoryWavetable : Wavetable {
+    std::vector<uint8_t> bytes;
+};
+
+// Written under a temporary name and renamed, so a cache file is never seen half written
+bool writeCache(const std::string& path, const std::vector<uint8_t>& bytes) {
+    std::string tempPath = path + ".tmp";
+    try {
+        system::writeFile(tempPath, bytes);
+    }
+    catch (Exception& e) {
+        return false;
+    }
+    if (!system::rename(tempPath, path)) {
+        system::remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+uint64_t hashBytes(const std::vector<uint8_t>& bytes) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint8_t b : bytes) {
+        hash ^= b;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Tables currently loaded by any module, by source file content. Entries of tables no
+// module holds any more are erased on the next load.
+std::mutex registryMutex;
+std::map<uint64_t, std::weak_ptr<const Wavetable>> registry;
+
+std::string cacheFilename(uint64_t hash) {
+    return string::f("%016llx.bin", (unsigned long long)hash);
+}
+
+// registryMutex held: remove cache files of tables that aren't loaded, until the cache fits
+// in CACHE_LIMIT_BYTES
+void trimCache(const std::string& cacheDir) {
+    std::vector<std::string> entries = system::getEntries(cacheDir);
+    std::vector<uint64_t> sizes(entries.size());
+    uint64_t total = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        sizes[i] = system::getFileSize(entries[i]);
+        total += sizes[i];
+    }
+    std::map<std::string, bool> loaded;
+    for (const auto& entry : registry)
+        loaded[cacheFilename(entry.first)] = true;
+
+    for (size_t i = 0; i < entries.size() && total > CACHE_LIMIT_BYTES; i++) {
+        std::string name = system::getFilename(entries[i]);
+        if (loaded.count(name))
+            continue;
+        if (system::remove(entries[i]))
+            total -= sizes[i];
+    }
+}
+
+} // namespace
+
+std::shared_ptr<const Wavetable> loadWavetable(const std::string& path, std::string& error) {
+    std::vector<uint8_t> file;
+    try {
+        file = system::readFile(path);
+    }
+    catch (Exception& e) {
+        error = e.what();
+        return nullptr;
+    }
+    uint64_t hash = hashBytes(file) ^ CACHE_VERSION;
+
+    // Held while loading, so two modules asking for the same new file don't both build it
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto it = registry.begin(); it != registry.end();) {
+        if (it->second.expired())
+            it = registry.erase(it);
+        else
+            ++it;
+    }
+    auto it = registry.find(hash);
+    if (it != registry.end()) {
+        // The last module holding it may have let go since the sweep
+        std::shared_ptr<const Wavetable> table = it->second.lock();
+        if (table)
+            return table;
+    }
+
+    std::string cacheDir = asset::user(system::join(pluginInstance->slug, "wavetables"));
+    std::string cachePath = system::join(cacheDir, cacheFilename(hash));
+
+    std::shared_ptr<MappedWavetable> mapped = std::make_shared<MappedWavetable>();
+    if (!mapped->open(cachePath)) {
+        std::vector<float> samples;
+        std::vector<uint8_t> cache;
+        if (!decodeWav(file, samples, error) || !buildTable(samples, cache, error))
+            return nullptr;
+
+        system::createDirectories(cacheDir);
+        trimCache(cacheDir);
+        mapped = std::make_shared<MappedWavetable>();
+        if (!writeCache(cachePath, cache) || !mapped->open(cachePath)) {
+            std::shared_ptr<MemoryWavetable> memory = std::make_shared<MemoryWavetable>();
+            memory->bytes = std::move(cache);
+            parseCache(memory->bytes.data(), memory->bytes.size(), *memory);
+            registry[hash] = memory;
+            return memory;
+        }
+    }
+    registry[hash] = mapped;
+    return mapped;
+}
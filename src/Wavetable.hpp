@@ -0,0 +1,90 @@
+#pragma once
+#include "plugin.hpp"
+#include <cstring>
+#include <memory>
+
+// A wavetable loaded from a WAV file: one or more single-cycle frames, each stored as
+// a set of band-limited mip levels. Level l keeps the harmonics below frameLength / 2^(l+1),
+// so a note can always pick a level that doesn't alias.
+//
+// The levels are computed once per distinct file and written to a cache file in the user
+// folder. Tables are read straight from a read-only memory mapping of that file, and every
+// module playing the same file shares one mapping, so loading a patch never recomputes or
+// copies a table that is already known.
+struct Wavetable {
+    static const int MAX_LEVELS = 16;
+    static const int MAX_FRAMES = 256;
+
+    // Samples per frame in the source file
+    int frameLength = 0;
+    int frames = 0;
+    int levels = 0;
+    // Samples per cycle of each level; smaller levels need fewer samples. Every frame of a
+    // level is followed by a copy of its first sample, so interpolation never wraps.
+    int levelLength[MAX_LEVELS] = {};
+    // Start of frame 0 of each level in data; frame f starts levelLength + 1 samples later
+    size_t levelOffset[MAX_LEVELS] = {};
+    const float* data = nullptr;
+
+    virtual ~Wavetable() {}
+
+    const float* getFrame(int level, int frame) const {
+        return data + levelOffset[level] + (size_t)frame * (levelLength[level] + 1);
+    }
+};
+
+// Loads a WAV wavetable, or returns the copy another module already loaded. On failure
+// returns null and sets error.
+std::shared_ptr<const Wavetable> loadWavetable(const std::string& path, std::string& error);
+
+// Reads one lane of a wavetable at a given frequency and frame position: two neighbouring
+// mip levels, each interpolated between two frames, crossfaded so the brightness changes
+// smoothly with pitch. Set once per sample, read once per (oversampled) step.
+struct WavetableReader {
+    // [level][frame]
+    const float* frames[2][2];
+    int length[2];
+    float frameFade = 0.f;
+    float levelFade = 0.f;
+
+    // deltaPhase: cycles per output sample; position: 0 to 1 across the frames
+    void set(const Wavetable& table, float deltaPhase, float position) {
+        // x = harmonics of the full table per Nyquist. Level floor(log2 x) + 1 is the first
+        // without aliasing; the fade to the next one follows the mantissa of x.
+        float x = deltaPhase * table.frameLength;
+        int32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        int exponent = ((bits >> 23) & 0xff) - 127;
+        bits = (bits & 0x7fffff) | 0x3f800000;
+        std::memcpy(&levelFade, &bits, sizeof(levelFade));
+        levelFade -= 1.f;
+
+        float frame = clamp(position, 0.f, 1.f) * (table.frames - 1);
+        int frame0 = (int)frame;
+        int frame1 = std::min(frame0 + 1, table.frames - 1);
+        frameFade = frame - frame0;
+
+        for (int i = 0; i < 2; i++) {
+            int level = clamp(exponent + 1 + i, 0, table.levels - 1);
+            frames[i][0] = table.getFrame(level, frame0);
+            frames[i][1] = table.getFrame(level, frame1);
+            length[i] = table.levelLength[level];
+        }
+    }
+
+    // phase in [0, 1)
+    float read(float phase) const {
+        float y[2];
+        for (int i = 0; i < 2; i++) {
+            float index = phase * length[i];
+            int i0 = std::min((int)index, length[i] - 1);
+            float frac = index - i0;
+            const float* a = frames[i][0] + i0;
+            const float* b = frames[i][1] + i0;
+            float ya = a[0] + frac * (a[1] - a[0]);
+            float yb = b[0] + frac * (b[1] - b[0]);
+            y[i] = ya + frameFade * (yb - ya);
+        }
+        return y[0] + levelFade * (y[1] - y[0]);
+    }
+};
@@ -1,10 +1,16 @@
 #include "plugin.hpp"
+#include "JuliaRender.hpp"
 
 Plugin* pluginInstance;
 
+// Shared by every JuliaScope in the patch
+JuliaScheduler juliaScheduler;
+
 void init(Plugin* p) {
     pluginInstance = p;
 
+    juliaScheduler.start(JuliaScheduler::defaultWorkerCount());
+
     p->addModel(modelSimpleVCO);
     p->addModel(modelJuliaScope);
 }